@@ -0,0 +1,212 @@
+// Checks NavGraph against a brute-force grid Dijkstra on a steep heightfield
+// (obstacles, entrances and rebuildRegion all get exercised, unlike the
+// shipped terrain) and times single and batched queries. Built only with
+// -DMINI_FPS_BUILD_BENCH=ON.
+
+#include "NavGraph.hpp"
+#include "Terrain.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr int kTerrainCells = 48;
+constexpr float kTerrainSpacing = 2.5f;
+constexpr float kNavCell = kTerrainSpacing * 0.5f;
+constexpr int kNavCells = kTerrainCells * 2;
+
+constexpr int kSources = 200;
+constexpr int kGoalsPerSource = 15;
+// HPA* with string pulling is near-optimal, not optimal; this bounds how far off it may be.
+constexpr double kMaxLengthRatio = 1.2;
+constexpr int kTimedQueries = 20000;
+constexpr int kRebuilds = 500;
+constexpr int kRepeatedQueries = 50;
+
+using Clock = std::chrono::steady_clock;
+
+float steepHeight(float x, float z) {
+    return 5.0f * std::sin(0.45f * x) * std::cos(0.4f * z);
+}
+
+double elapsedSeconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+glm::vec3 cellCenter(int x, int z) {
+    const float origin = -kTerrainCells * kTerrainSpacing * 0.5f;
+    return {origin + (static_cast<float>(x) + 0.5f) * kNavCell, 0.0f, origin + (static_cast<float>(z) + 0.5f) * kNavCell};
+}
+
+float pathLength(const NavPath& path) {
+    float length = 0.0f;
+    for (size_t i = 1; i < path.waypoints.size(); ++i) {
+        const glm::vec3 d = path.waypoints[i] - path.waypoints[i - 1];
+        length += std::sqrt(d.x * d.x + d.z * d.z);
+    }
+    return length;
+}
+
+// True when every point along the waypoint segments lies on a walkable cell.
+bool segmentsWalkable(const NavGraph& nav, const NavPath& path) {
+    for (size_t i = 1; i < path.waypoints.size(); ++i) {
+        const glm::vec3 a = path.waypoints[i - 1];
+        const glm::vec3 b = path.waypoints[i];
+        const glm::vec3 d = b - a;
+        const int samples = std::max(1, static_cast<int>(std::sqrt(d.x * d.x + d.z * d.z) / (kNavCell * 0.125f)));
+        for (int s = 0; s <= samples; ++s) {
+            const float t = static_cast<float>(s) / static_cast<float>(samples);
+            if (!nav.isWalkable(glm::vec3(a.x + d.x * t, 0.0f, a.z + d.z * t))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 8-connected grid Dijkstra with the same no-corner-cutting rule as NavGraph::canStep.
+void gridDistances(const std::vector<std::uint8_t>& walkable, int source, std::vector<float>& dist) {
+    dist.assign(walkable.size(), std::numeric_limits<float>::infinity());
+    using Entry = std::pair<float, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    dist[static_cast<size_t>(source)] = 0.0f;
+    open.push({0.0f, source});
+
+    auto isOpen = [&](int x, int z) {
+        return x >= 0 && z >= 0 && x < kNavCells && z < kNavCells && walkable[static_cast<size_t>(z * kNavCells + x)];
+    };
+    while (!open.empty()) {
+        const auto [d, cell] = open.top();
+        open.pop();
+        if (d > dist[static_cast<size_t>(cell)]) {
+            continue;
+        }
+        const int x = cell % kNavCells;
+        const int z = cell / kNavCells;
+        for (int dz = -1; dz <= 1; ++dz) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if ((dx == 0 && dz == 0) || !isOpen(x + dx, z + dz)) {
+                    continue;
+                }
+                if (dx != 0 && dz != 0 && (!isOpen(x + dx, z) || !isOpen(x, z + dz))) {
+                    continue;
+                }
+                const float next = d + (dx != 0 && dz != 0 ? 1.41421356f : 1.0f) * kNavCell;
+                const int neighbour = (z + dz) * kNavCells + (x + dx);
+                if (next < dist[static_cast<size_t>(neighbour)]) {
+                    dist[static_cast<size_t>(neighbour)] = next;
+                    open.push({next, neighbour});
+                }
+            }
+        }
+    }
+}
+}  // namespace
+
+int main() {
+    TerrainSettings settings;
+    settings.gridSize = kTerrainCells;
+    settings.cellSpacing = kTerrainSpacing;
+    settings.height = steepHeight;
+    settings.gpuMesh = false;
+    const Terrain terrain(settings);
+    const NavGraph nav(terrain, kNavCell);
+
+    std::vector<std::uint8_t> walkable(static_cast<size_t>(kNavCells * kNavCells));
+    std::vector<int> walkableCells;
+    for (int z = 0; z < kNavCells; ++z) {
+        for (int x = 0; x < kNavCells; ++x) {
+            const bool open = nav.isWalkable(cellCenter(x, z));
+            walkable[static_cast<size_t>(z * kNavCells + x)] = open ? 1 : 0;
+            if (open) {
+                walkableCells.push_back(z * kNavCells + x);
+            }
+        }
+    }
+    std::printf("%d of %d cells walkable\n", static_cast<int>(walkableCells.size()), kNavCells * kNavCells);
+
+    // Correctness against grid Dijkstra.
+    std::mt19937 rng(7u);
+    std::uniform_int_distribution<size_t> pick(0, walkableCells.size() - 1);
+    std::vector<float> dist;
+    int reachabilityMismatches = 0;
+    int blockedSegments = 0;
+    int compared = 0;
+    int longer = 0;
+    double ratioSum = 0.0;
+    double worstRatio = 0.0;
+    for (int s = 0; s < kSources; ++s) {
+        const int source = walkableCells[pick(rng)];
+        gridDistances(walkable, source, dist);
+        for (int g = 0; g < kGoalsPerSource; ++g) {
+            const int goal = walkableCells[pick(rng)];
+            const float best = dist[static_cast<size_t>(goal)];
+            const NavPath path = nav.findPath(cellCenter(source % kNavCells, source / kNavCells),
+                                              cellCenter(goal % kNavCells, goal / kNavCells));
+            if (path.found != std::isfinite(best)) {
+                ++reachabilityMismatches;
+                continue;
+            }
+            if (!path.found || best <= 0.0f) {
+                continue;
+            }
+            blockedSegments += segmentsWalkable(nav, path) ? 0 : 1;
+            const double ratio = static_cast<double>(pathLength(path)) / static_cast<double>(best);
+            ratioSum += ratio;
+            worstRatio = std::max(worstRatio, ratio);
+            longer += ratio > 1.001 ? 1 : 0;
+            ++compared;
+        }
+    }
+    std::printf("vs grid Dijkstra: %d reachable pairs, length ratio mean %.3f worst %.3f, %d longer | "
+                "%d reachability mismatches, %d paths crossing unwalkable cells\n",
+                compared, compared > 0 ? ratioSum / compared : 0.0, worstRatio, longer, reachabilityMismatches, blockedSegments);
+
+    // Throughput on mostly uncached random queries.
+    const float extent = kTerrainCells * kTerrainSpacing * 0.5f;
+    std::uniform_real_distribution<float> place(-extent, extent);
+    std::vector<NavQuery> queries(kTimedQueries);
+    for (NavQuery& query : queries) {
+        query.start = glm::vec3(place(rng), 0.0f, place(rng));
+        query.goal = glm::vec3(place(rng), 0.0f, place(rng));
+    }
+
+    const NavGraph timed(terrain, kNavCell);
+    auto start = Clock::now();
+    int found = 0;
+    for (const NavQuery& query : queries) {
+        found += timed.findPath(query.start, query.goal).found ? 1 : 0;
+    }
+    const double singleSeconds = elapsedSeconds(start);
+
+    const NavGraph batched(terrain, kNavCell);
+    std::vector<NavPath> results;
+    start = Clock::now();
+    batched.findPaths(queries, results);
+    const double batchSeconds = elapsedSeconds(start);
+    std::printf("%d queries (%d found): %.1fk/s on one thread, %.1fk/s through findPaths\n", kTimedQueries, found,
+                kTimedQueries / singleSeconds / 1000.0, kTimedQueries / batchSeconds / 1000.0);
+
+    // The cache must stay bounded by the live entries across rebuilds.
+    NavGraph rebuilt(terrain, kNavCell);
+    for (int r = 0; r < kRebuilds; ++r) {
+        for (int q = 0; q < kRepeatedQueries; ++q) {
+            (void)rebuilt.findPath(queries[static_cast<size_t>(q)].start, queries[static_cast<size_t>(q)].goal);
+        }
+        rebuilt.rebuildRegion(terrain, glm::vec2(-extent), glm::vec2(extent));
+    }
+    const NavCacheStats cache = rebuilt.cacheStats();
+    const bool cacheBounded = cache.entries <= static_cast<size_t>(kRepeatedQueries) && cache.orderEntries == cache.entries;
+    std::printf("cache after %d rebuilds: %zu entries, %zu in eviction order\n", kRebuilds, cache.entries, cache.orderEntries);
+
+    const bool ok = reachabilityMismatches == 0 && blockedSegments == 0 && worstRatio <= kMaxLengthRatio && cacheBounded;
+    std::printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
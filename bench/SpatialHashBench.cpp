@@ -0,0 +1,125 @@
+// Times SpatialHash with 10k-100k entities drifting between ticks and checks
+// its answers against brute force. Built only with -DMINI_FPS_BUILD_BENCH=ON.
+
+#include "SpatialHash.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr float kCellSize = 2.5f;  // Terrain::cellSpacing()
+constexpr float kQueryRadius = 10.0f;
+constexpr float kPairRadius = 1.0f;
+constexpr float kDriftPerTick = 0.1f;
+constexpr int kTicks = 20;
+constexpr int kValidatedQueries = 200;
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+float distanceSquaredXZ(const glm::vec3& a, const glm::vec3& b) {
+    const float dx = a.x - b.x;
+    const float dz = a.z - b.z;
+    return dx * dx + dz * dz;
+}
+
+// Returns the number of mismatching answers.
+int validate(const SpatialHash& hash, const std::vector<glm::vec3>& positions, bool checkPairs) {
+    int mismatches = 0;
+    std::vector<std::uint32_t> ids;
+    for (int i = 0; i < kValidatedQueries; ++i) {
+        const glm::vec3& center = positions[static_cast<size_t>(i)];
+
+        hash.queryRadius(center, kQueryRadius, ids);
+        size_t expected = 0;
+        for (const glm::vec3& p : positions) {
+            expected += distanceSquaredXZ(p, center) <= kQueryRadius * kQueryRadius ? 1 : 0;
+        }
+        mismatches += ids.size() != expected ? 1 : 0;
+
+        const glm::vec2 minXZ(center.x - 3.0f, center.z - 5.0f);
+        const glm::vec2 maxXZ(center.x + 4.0f, center.z + 2.0f);
+        hash.queryAabb(minXZ, maxXZ, ids);
+        expected = 0;
+        for (const glm::vec3& p : positions) {
+            expected += p.x >= minXZ.x && p.x <= maxXZ.x && p.z >= minXZ.y && p.z <= maxXZ.y ? 1 : 0;
+        }
+        mismatches += ids.size() != expected ? 1 : 0;
+    }
+
+    if (checkPairs) {
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> pairs;
+        hash.findPairs(kPairRadius, pairs);
+        size_t expected = 0;
+        for (size_t i = 0; i < positions.size(); ++i) {
+            for (size_t j = i + 1; j < positions.size(); ++j) {
+                expected += distanceSquaredXZ(positions[i], positions[j]) < kPairRadius * kPairRadius ? 1 : 0;
+            }
+        }
+        mismatches += pairs.size() != expected ? 1 : 0;
+    }
+    return mismatches;
+}
+}  // namespace
+
+int main() {
+    int failures = 0;
+    for (int count : {10000, 30000, 100000}) {
+        // Keep density constant (~1.6 entities per cell) as the count grows.
+        const float world = std::sqrt(static_cast<float>(count)) * 2.0f;
+        std::mt19937 rng(static_cast<std::uint32_t>(count));
+        std::uniform_real_distribution<float> place(-world * 0.5f, world * 0.5f);
+        std::uniform_real_distribution<float> drift(-kDriftPerTick, kDriftPerTick);
+
+        std::vector<glm::vec3> positions(static_cast<size_t>(count));
+        for (glm::vec3& p : positions) {
+            p = glm::vec3(place(rng), 0.0f, place(rng));
+        }
+
+        SpatialHash hash(kCellSize);
+        std::vector<std::uint32_t> ids;
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> pairs;
+        double rebuildMs = 0.0;
+        double queryMs = 0.0;
+        double pairMs = 0.0;
+        size_t hits = 0;
+
+        for (int tick = 0; tick < kTicks; ++tick) {
+            for (glm::vec3& p : positions) {
+                p.x += drift(rng);
+                p.z += drift(rng);
+            }
+
+            auto start = Clock::now();
+            hash.rebuild(positions);
+            rebuildMs += elapsedMs(start);
+
+            start = Clock::now();
+            for (const glm::vec3& p : positions) {
+                hash.queryRadius(p, kQueryRadius, ids);
+                hits += ids.size();
+            }
+            queryMs += elapsedMs(start);
+
+            start = Clock::now();
+            hash.findPairs(kPairRadius, pairs);
+            pairMs += elapsedMs(start);
+        }
+
+        // Brute-force pairs are O(n^2); only check them at the smallest size.
+        const int mismatches = validate(hash, positions, count == 10000);
+        failures += mismatches;
+
+        std::printf("%6d entities | rebuild %7.3f ms | %d radius(%.0f) queries %8.2f ms (avg %zu hits) | pairs(%.0f) %6.2f ms (%zu) | %s\n",
+                    count, rebuildMs / kTicks, count, static_cast<double>(kQueryRadius), queryMs / kTicks,
+                    hits / (static_cast<size_t>(count) * kTicks), static_cast<double>(kPairRadius), pairMs / kTicks, pairs.size(),
+                    mismatches == 0 ? "matches brute force" : "MISMATCH");
+    }
+    return failures == 0 ? 0 : 1;
+}
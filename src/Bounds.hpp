@@ -0,0 +1,8 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+struct Aabb {
+    glm::vec3 min{0.0f};
+    glm::vec3 max{0.0f};
+};
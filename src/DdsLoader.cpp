@@ -0,0 +1,128 @@
+#include "DdsLoader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+constexpr std::uint32_t kDdsMagic = 0x20534444u;  // "DDS "
+constexpr size_t kHeaderSize = 124;
+constexpr size_t kDx10HeaderSize = 20;
+constexpr std::uint32_t kPixelFormatFourCC = 0x4u;
+constexpr std::uint32_t kCaps2Cubemap = 0x200u;
+constexpr std::uint32_t kCaps2Volume = 0x200000u;
+
+constexpr std::uint32_t fourCC(char a, char b, char c, char d) {
+    return static_cast<std::uint32_t>(a) | (static_cast<std::uint32_t>(b) << 8) | (static_cast<std::uint32_t>(c) << 16) |
+           (static_cast<std::uint32_t>(d) << 24);
+}
+
+std::uint32_t readU32(const std::vector<std::uint8_t>& bytes, size_t offset) {
+    std::uint32_t value = 0;
+    std::memcpy(&value, bytes.data() + offset, sizeof(value));
+    return value;
+}
+
+struct BlockFormat {
+    GLenum internalFormat = 0;
+    size_t blockBytes = 0;
+};
+
+// sRGB variants map to the linear formats: the renderer does no gamma
+// correction, so textures are sampled as authored.
+BlockFormat formatFromDxgi(std::uint32_t dxgiFormat) {
+    switch (dxgiFormat) {
+    case 71:  // BC1_UNORM
+    case 72:  // BC1_UNORM_SRGB
+        return {GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 8};
+    case 77:  // BC3_UNORM
+    case 78:  // BC3_UNORM_SRGB
+        return {GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 16};
+    case 83:  // BC5_UNORM
+        return {GL_COMPRESSED_RG_RGTC2, 16};
+    default:
+        return {};
+    }
+}
+
+BlockFormat formatFromFourCC(std::uint32_t code) {
+    if (code == fourCC('D', 'X', 'T', '1')) return {GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 8};
+    if (code == fourCC('D', 'X', 'T', '5')) return {GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 16};
+    if (code == fourCC('A', 'T', 'I', '2') || code == fourCC('B', 'C', '5', 'U')) return {GL_COMPRESSED_RG_RGTC2, 16};
+    return {};
+}
+}  // namespace
+
+TextureImage loadDds(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open texture: " + path);
+    }
+    const std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (bytes.size() < 4 + kHeaderSize || readU32(bytes, 0) != kDdsMagic || readU32(bytes, 4) != kHeaderSize) {
+        throw std::runtime_error("Not a DDS file: " + path);
+    }
+
+    // Offsets are relative to the start of the file (magic included).
+    const auto height = static_cast<int>(readU32(bytes, 12));
+    const auto width = static_cast<int>(readU32(bytes, 16));
+    const int mipCount = std::max(1, static_cast<int>(readU32(bytes, 28)));
+    const std::uint32_t pixelFlags = readU32(bytes, 80);
+    const std::uint32_t code = readU32(bytes, 84);
+    const std::uint32_t caps2 = readU32(bytes, 112);
+
+    if (width <= 0 || height <= 0 || (caps2 & (kCaps2Cubemap | kCaps2Volume)) != 0) {
+        throw std::runtime_error("Unsupported DDS layout (only single 2D images): " + path);
+    }
+    if ((pixelFlags & kPixelFormatFourCC) == 0) {
+        throw std::runtime_error("Uncompressed DDS is not supported: " + path);
+    }
+
+    size_t offset = 4 + kHeaderSize;
+    BlockFormat format;
+    if (code == fourCC('D', 'X', '1', '0')) {
+        if (bytes.size() < offset + kDx10HeaderSize) {
+            throw std::runtime_error("Truncated DDS header: " + path);
+        }
+        if (readU32(bytes, offset + 12) > 1) {
+            throw std::runtime_error("DDS texture arrays are not supported: " + path);
+        }
+        format = formatFromDxgi(readU32(bytes, offset));
+        offset += kDx10HeaderSize;
+    } else {
+        format = formatFromFourCC(code);
+    }
+    if (format.internalFormat == 0) {
+        throw std::runtime_error("DDS format is not BC1, BC3 or BC5: " + path);
+    }
+
+    TextureImage image;
+    image.internalFormat = format.internalFormat;
+    image.compressed = true;
+    image.levels.reserve(static_cast<size_t>(mipCount));
+
+    int levelWidth = width;
+    int levelHeight = height;
+    for (int level = 0; level < mipCount; ++level) {
+        const size_t blocksX = static_cast<size_t>(std::max(1, (levelWidth + 3) / 4));
+        const size_t blocksY = static_cast<size_t>(std::max(1, (levelHeight + 3) / 4));
+        const size_t size = blocksX * blocksY * format.blockBytes;
+        if (offset + size > bytes.size()) {
+            throw std::runtime_error("Truncated DDS mip chain: " + path);
+        }
+
+        TextureLevel& mip = image.levels.emplace_back();
+        mip.width = levelWidth;
+        mip.height = levelHeight;
+        mip.data.assign(bytes.begin() + static_cast<std::ptrdiff_t>(offset), bytes.begin() + static_cast<std::ptrdiff_t>(offset + size));
+
+        offset += size;
+        levelWidth = std::max(1, levelWidth / 2);
+        levelHeight = std::max(1, levelHeight / 2);
+    }
+
+    return image;
+}
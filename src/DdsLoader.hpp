@@ -0,0 +1,25 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct TextureLevel {
+    int width = 0;
+    int height = 0;
+    std::vector<std::uint8_t> data;
+};
+
+// A 2D image with its mip chain, finest level first. `compressed` images hold
+// BCn blocks in `internalFormat`; uncompressed ones hold tightly packed RGBA8.
+struct TextureImage {
+    GLenum internalFormat = 0;
+    bool compressed = false;
+    std::vector<TextureLevel> levels;
+};
+
+// Reads a BC1, BC3 or BC5 DDS file (legacy FourCC or DX10 header) with all
+// the mip levels it contains. Throws std::runtime_error on anything else.
+TextureImage loadDds(const std::string& path);
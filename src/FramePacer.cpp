@@ -0,0 +1,141 @@
+#include "FramePacer.hpp"
+
+#include "InputQueue.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace {
+constexpr GLuint64 kFenceTimeoutNs = 1'000'000'000ull;
+// Below this remaining time the cap spins instead of trusting the OS sleep.
+constexpr std::uint64_t kSpinThresholdNs = 1'500'000ull;
+constexpr int kLatencyWindowFrames = 60;
+}  // namespace
+
+FramePacer::FramePacer(const FramePacingSettings& settings) : m_settings(settings) {}
+
+FramePacer::~FramePacer() {
+    for (const InFlightFrame& frame : m_inFlight) {
+        release(frame);
+    }
+    if (!m_freeQueries.empty()) {
+        glDeleteQueries(static_cast<GLsizei>(m_freeQueries.size()), m_freeQueries.data());
+    }
+}
+
+void FramePacer::waitForFrameStart() {
+    const std::uint64_t waitStart = inputTimestampNow();
+
+    retireSignaled();
+
+    if (m_settings.maxFramesInFlight > 0) {
+        while (static_cast<int>(m_inFlight.size()) >= m_settings.maxFramesInFlight) {
+            const InFlightFrame frame = m_inFlight.front();
+            m_inFlight.pop_front();
+            // A timeout or failure still frees the slot, otherwise a lost
+            // fence would block forever, but the frame is not measured.
+            const GLenum status = glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeoutNs);
+            retire(frame, status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED);
+        }
+    }
+
+    if (m_settings.frameRateCap > 0.0f) {
+        const auto periodNs = static_cast<std::uint64_t>(1e9 / static_cast<double>(m_settings.frameRateCap));
+        const std::uint64_t now = inputTimestampNow();
+        if (m_nextFrameStartNs > now) {
+            sleepUntil(m_nextFrameStartNs);
+        }
+        // Schedule from the later of the planned and actual start so a slow
+        // frame does not trigger a burst of uncapped catch-up frames.
+        m_nextFrameStartNs = std::max(m_nextFrameStartNs, now) + periodNs;
+    }
+
+    m_latency.waitMs = static_cast<float>(inputTimestampNow() - waitStart) * 1e-6f;
+}
+
+void FramePacer::markInputSampled() {
+    m_inputSampledNs = inputTimestampNow();
+}
+
+void FramePacer::endFrame() {
+    InFlightFrame frame;
+    if (m_freeQueries.empty()) {
+        frame.timestampQuery = 0;
+        glGenQueries(1, &frame.timestampQuery);
+    } else {
+        frame.timestampQuery = m_freeQueries.back();
+        m_freeQueries.pop_back();
+    }
+    // Written by the GPU once everything before it, including the swap's blit, has executed.
+    glQueryCounter(frame.timestampQuery, GL_TIMESTAMP);
+
+    GLint64 glNowNs = 0;
+    glGetInteger64v(GL_TIMESTAMP, &glNowNs);
+    frame.gpuToCpuNs = static_cast<std::int64_t>(inputTimestampNow()) - static_cast<std::int64_t>(glNowNs);
+
+    frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame.inputSampledNs = m_inputSampledNs;
+    m_inFlight.push_back(frame);
+}
+
+void FramePacer::retireSignaled() {
+    while (!m_inFlight.empty()) {
+        const GLenum status = glClientWaitSync(m_inFlight.front().fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+        const InFlightFrame frame = m_inFlight.front();
+        m_inFlight.pop_front();
+        retire(frame, true);
+    }
+}
+
+void FramePacer::release(const InFlightFrame& frame) {
+    glDeleteSync(frame.fence);
+    m_freeQueries.push_back(frame.timestampQuery);
+}
+
+void FramePacer::retire(const InFlightFrame& frame, bool completed) {
+    GLuint64 gpuDoneNs = 0;
+    if (completed) {
+        // The fence follows the timestamp, so the result is available without stalling.
+        glGetQueryObjectui64v(frame.timestampQuery, GL_QUERY_RESULT, &gpuDoneNs);
+    }
+    release(frame);
+    if (!completed) {
+        ++m_latency.unmeasuredFrames;
+        return;
+    }
+
+    // When the GPU actually got there, not when the CPU next checked the fence.
+    const std::int64_t doneNs = static_cast<std::int64_t>(gpuDoneNs) + frame.gpuToCpuNs;
+    const std::int64_t elapsedNs = std::max<std::int64_t>(0, doneNs - static_cast<std::int64_t>(frame.inputSampledNs));
+    const float latencyMs = static_cast<float>(elapsedNs) * 1e-6f;
+    m_latency.lastMs = latencyMs;
+
+    m_windowSumMs += latencyMs;
+    m_windowMaxMs = std::max(m_windowMaxMs, latencyMs);
+    if (++m_windowFrames >= kLatencyWindowFrames) {
+        m_latency.averageMs = m_windowSumMs / static_cast<float>(m_windowFrames);
+        m_latency.maxMs = m_windowMaxMs;
+        m_windowSumMs = 0.0f;
+        m_windowMaxMs = 0.0f;
+        m_windowFrames = 0;
+    }
+}
+
+void FramePacer::sleepUntil(std::uint64_t targetNs) {
+    for (;;) {
+        const std::uint64_t now = inputTimestampNow();
+        if (now >= targetNs) {
+            return;
+        }
+        const std::uint64_t remaining = targetNs - now;
+        if (remaining > kSpinThresholdNs) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(remaining - kSpinThresholdNs));
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
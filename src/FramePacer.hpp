@@ -0,0 +1,77 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+struct FramePacingSettings {
+    // Frames the CPU may run ahead of the GPU. 1 gives the lowest latency,
+    // larger values trade latency for throughput. 0 leaves it to the driver.
+    int maxFramesInFlight = 2;
+    // Frames per second; 0 disables the cap.
+    float frameRateCap = 0.0f;
+};
+
+struct FrameLatencyStats {
+    // Input sample to the GPU timestamp taken right after that frame's swap,
+    // converted to the CPU clock.
+    float lastMs = 0.0f;
+    float averageMs = 0.0f;
+    float maxMs = 0.0f;
+    // Time spent blocked on fences or the frame-rate cap before sampling input.
+    float waitMs = 0.0f;
+    // Frames whose fence timed out or failed; they are left out of the latency numbers.
+    int unmeasuredFrames = 0;
+};
+
+// Bounds how far the CPU runs ahead of the GPU with fence syncs and applies
+// the frame-rate cap immediately before input is sampled, so any waiting
+// happens while input is still accumulating rather than after it was read.
+class FramePacer {
+public:
+    explicit FramePacer(const FramePacingSettings& settings = {});
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    void setSettings(const FramePacingSettings& settings) { m_settings = settings; }
+    const FramePacingSettings& settings() const { return m_settings; }
+
+    // Call right before polling events / sampling input.
+    void waitForFrameStart();
+    // Call once the frame's input has been sampled.
+    void markInputSampled();
+    // Call right after swapBuffers().
+    void endFrame();
+
+    const FrameLatencyStats& latency() const { return m_latency; }
+
+private:
+    struct InFlightFrame {
+        GLsync fence = nullptr;
+        GLuint timestampQuery = 0;
+        std::uint64_t inputSampledNs = 0;
+        // CPU clock minus GL clock, sampled when the frame was submitted.
+        std::int64_t gpuToCpuNs = 0;
+    };
+
+    FramePacingSettings m_settings;
+    std::deque<InFlightFrame> m_inFlight;
+    std::vector<GLuint> m_freeQueries;
+    std::uint64_t m_inputSampledNs = 0;
+    std::uint64_t m_nextFrameStartNs = 0;
+
+    FrameLatencyStats m_latency;
+    // Window for the rolling average / max.
+    float m_windowSumMs = 0.0f;
+    float m_windowMaxMs = 0.0f;
+    int m_windowFrames = 0;
+
+    void retire(const InFlightFrame& frame, bool completed);
+    void release(const InFlightFrame& frame);
+    void retireSignaled();
+    void sleepUntil(std::uint64_t targetNs);
+};
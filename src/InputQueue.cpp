@@ -0,0 +1,39 @@
+#include "InputQueue.hpp"
+
+#include <chrono>
+
+std::uint64_t inputTimestampNow() {
+    const auto sinceEpoch = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(sinceEpoch).count());
+}
+
+bool InputEventQueue::push(const InputEvent& event) {
+    const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) == kCapacity) {
+        return false;
+    }
+
+    m_events[tail & (kCapacity - 1)] = event;
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+const InputEvent* InputEventQueue::front() const {
+    const std::size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return &m_events[head & (kCapacity - 1)];
+}
+
+const InputEvent* InputEventQueue::peek(std::size_t index) const {
+    const std::size_t head = m_head.load(std::memory_order_relaxed);
+    if (m_tail.load(std::memory_order_acquire) - head <= index) {
+        return nullptr;
+    }
+    return &m_events[(head + index) & (kCapacity - 1)];
+}
+
+void InputEventQueue::pop() {
+    m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Nanoseconds on the steady clock; shared by input events and the fixed-tick
+// simulation so both sides compare timestamps in the same units.
+std::uint64_t inputTimestampNow();
+
+struct InputEvent {
+    enum class Type : std::uint8_t { Key, MouseMove };
+
+    Type type = Type::Key;
+    bool pressed = false;
+    int key = 0;
+    float deltaX = 0.0f;
+    float deltaY = 0.0f;
+    std::uint64_t timestampNs = 0;
+};
+
+// Single-producer/single-consumer ring buffer. The window callbacks push,
+// the simulation pops; neither side takes a lock.
+class InputEventQueue {
+public:
+    static constexpr std::size_t kCapacity = 1024;
+
+    // Returns false and drops the event when the queue is full.
+    bool push(const InputEvent& event);
+
+    // Oldest unread event, or nullptr when empty. Valid until pop().
+    [[nodiscard]] const InputEvent* front() const;
+    // The `index`-th unread event (0 is front()), or nullptr. Consumer side only.
+    [[nodiscard]] const InputEvent* peek(std::size_t index) const;
+    void pop();
+
+private:
+    static_assert((kCapacity & (kCapacity - 1)) == 0, "kCapacity must be a power of two");
+
+    std::array<InputEvent, kCapacity> m_events{};
+    alignas(64) std::atomic<std::size_t> m_head{0};
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+};
@@ -0,0 +1,692 @@
+#include "NavGraph.hpp"
+
+#include "PlayerController.hpp"
+#include "Terrain.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <utility>
+
+namespace {
+constexpr float kInfinity = std::numeric_limits<float>::infinity();
+constexpr float kDiagonal = 1.41421356f;
+// Border openings longer than this get an entrance at each end instead of one in the middle.
+constexpr int kLongEntrance = 4;
+// How far (in cells) an unwalkable query endpoint is moved to find walkable ground.
+constexpr int kSnapRadius = 2;
+
+enum Via : std::uint8_t { kViaNone, kViaStart, kViaIntra, kViaPartner, kViaGoal };
+
+struct QueueItem {
+    float priority;
+    int cell;
+    bool operator>(const QueueItem& other) const { return priority > other.priority; }
+};
+
+using MinQueue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+// Per-thread search state, sized to the grid once and reset via stamps so a
+// query does not touch memory proportional to the whole map.
+struct SearchScratch {
+    std::vector<float> g;
+    std::vector<int> parent;
+    std::vector<std::uint8_t> via;
+    std::vector<std::uint32_t> seen;
+    std::vector<std::uint32_t> closed;
+    std::uint32_t stamp = 0;
+
+    std::vector<float> startDist;
+    std::vector<float> goalDist;
+    std::vector<std::int16_t> startParent;
+    std::vector<std::int16_t> goalParent;
+
+    void begin(size_t cellCount) {
+        if (g.size() != cellCount) {
+            g.assign(cellCount, kInfinity);
+            parent.assign(cellCount, -1);
+            via.assign(cellCount, kViaNone);
+            seen.assign(cellCount, 0);
+            closed.assign(cellCount, 0);
+            stamp = 0;
+        }
+        ++stamp;
+    }
+};
+
+thread_local SearchScratch t_scratch;
+
+float octile(int ax, int az, int bx, int bz) {
+    const int dx = std::abs(ax - bx);
+    const int dz = std::abs(az - bz);
+    return static_cast<float>(std::max(dx, dz)) + (kDiagonal - 1.0f) * static_cast<float>(std::min(dx, dz));
+}
+}  // namespace
+
+NavGraph::NavGraph(const Terrain& terrain, float cellSize, unsigned int workerThreads) : m_workers(workerThreads) {
+    m_cellSize = cellSize > 0.0f ? cellSize : terrain.cellSpacing() * 0.5f;
+    const float extent = terrain.halfExtent() * 2.0f;
+    m_origin = glm::vec2(-terrain.halfExtent());
+    m_cellsX = static_cast<int>(std::ceil(extent / m_cellSize));
+    m_cellsZ = m_cellsX;
+
+    const size_t cellCount = static_cast<size_t>(m_cellsX * m_cellsZ);
+    m_walkable.assign(cellCount, 0);
+    m_height.assign(cellCount, 0.0f);
+    m_nodeOfCell.assign(cellCount, -1);
+
+    sampleCells(terrain, 0, 0, m_cellsX, m_cellsZ);
+
+    m_clustersX = (m_cellsX + kClusterSize - 1) / kClusterSize;
+    m_clustersZ = (m_cellsZ + kClusterSize - 1) / kClusterSize;
+    m_clusters.resize(static_cast<size_t>(m_clustersX * m_clustersZ));
+    for (int cz = 0; cz < m_clustersZ; ++cz) {
+        for (int cx = 0; cx < m_clustersX; ++cx) {
+            Cluster& cluster = m_clusters[static_cast<size_t>(cz * m_clustersX + cx)];
+            cluster.x0 = cx * kClusterSize;
+            cluster.z0 = cz * kClusterSize;
+            cluster.x1 = std::min(cluster.x0 + kClusterSize, m_cellsX);
+            cluster.z1 = std::min(cluster.z0 + kClusterSize, m_cellsZ);
+        }
+    }
+
+    for (Cluster& cluster : m_clusters) {
+        buildCluster(cluster);
+    }
+}
+
+int NavGraph::clusterOf(int cell) const {
+    const int x = cell % m_cellsX;
+    const int z = cell / m_cellsX;
+    return (z / kClusterSize) * m_clustersX + (x / kClusterSize);
+}
+
+int NavGraph::localIndex(const Cluster& cluster, int cell) const {
+    const int x = cell % m_cellsX;
+    const int z = cell / m_cellsX;
+    return (z - cluster.z0) * cluster.width() + (x - cluster.x0);
+}
+
+int NavGraph::cellFromLocal(const Cluster& cluster, int local) const {
+    return cellIndex(cluster.x0 + local % cluster.width(), cluster.z0 + local / cluster.width());
+}
+
+glm::vec3 NavGraph::cellCenter(int cell) const {
+    const int x = cell % m_cellsX;
+    const int z = cell / m_cellsX;
+    return glm::vec3(m_origin.x + (static_cast<float>(x) + 0.5f) * m_cellSize, m_height[static_cast<size_t>(cell)],
+                     m_origin.y + (static_cast<float>(z) + 0.5f) * m_cellSize);
+}
+
+int NavGraph::cellAt(const glm::vec3& position) const {
+    const int x = static_cast<int>(std::floor((position.x - m_origin.x) / m_cellSize));
+    const int z = static_cast<int>(std::floor((position.z - m_origin.y) / m_cellSize));
+    if (x < 0 || z < 0 || x >= m_cellsX || z >= m_cellsZ) {
+        return -1;
+    }
+    return cellIndex(x, z);
+}
+
+int NavGraph::nearestWalkable(int cell) const {
+    if (cell < 0 || m_walkable[static_cast<size_t>(cell)]) {
+        return cell;
+    }
+
+    const int x = cell % m_cellsX;
+    const int z = cell / m_cellsX;
+    int best = -1;
+    int bestDistance = std::numeric_limits<int>::max();
+    for (int dz = -kSnapRadius; dz <= kSnapRadius; ++dz) {
+        for (int dx = -kSnapRadius; dx <= kSnapRadius; ++dx) {
+            const int nx = x + dx;
+            const int nz = z + dz;
+            if (nx < 0 || nz < 0 || nx >= m_cellsX || nz >= m_cellsZ || !m_walkable[static_cast<size_t>(cellIndex(nx, nz))]) {
+                continue;
+            }
+            const int distance = dx * dx + dz * dz;
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = cellIndex(nx, nz);
+            }
+        }
+    }
+    return best;
+}
+
+bool NavGraph::canStep(int fromX, int fromZ, int dx, int dz) const {
+    const int x = fromX + dx;
+    const int z = fromZ + dz;
+    if (x < 0 || z < 0 || x >= m_cellsX || z >= m_cellsZ || !m_walkable[static_cast<size_t>(cellIndex(x, z))]) {
+        return false;
+    }
+    if (dx != 0 && dz != 0) {
+        // No corner cutting past unwalkable cells.
+        return m_walkable[static_cast<size_t>(cellIndex(x, fromZ))] && m_walkable[static_cast<size_t>(cellIndex(fromX, z))];
+    }
+    return true;
+}
+
+bool NavGraph::hasLineOfSight(int fromCell, int toCell, std::vector<int>& crossed) const {
+    int x = fromCell % m_cellsX;
+    int z = fromCell / m_cellsX;
+    const int nx = std::abs(toCell % m_cellsX - x);
+    const int nz = std::abs(toCell / m_cellsX - z);
+    const int sx = toCell % m_cellsX > x ? 1 : -1;
+    const int sz = toCell / m_cellsX > z ? 1 : -1;
+
+    // Walk the cells in the order the segment enters them. The next x and z
+    // boundaries are crossed at (2ix+1)/2nx and (2iz+1)/2nz; comparing the
+    // cross-multiplied numerators keeps it exact, and a tie is a corner.
+    for (int ix = 0, iz = 0; ix < nx || iz < nz;) {
+        const long long tx = static_cast<long long>(2 * ix + 1) * nz;
+        const long long tz = static_cast<long long>(2 * iz + 1) * nx;
+        const int dx = tx <= tz ? sx : 0;
+        const int dz = tz <= tx ? sz : 0;
+        if (!canStep(x, z, dx, dz)) {
+            return false;
+        }
+        x += dx;
+        z += dz;
+        ix += dx != 0 ? 1 : 0;
+        iz += dz != 0 ? 1 : 0;
+        crossed.push_back(cellIndex(x, z));
+    }
+    return true;
+}
+
+void NavGraph::smoothPath(const std::vector<int>& cells, std::vector<int>& corners, std::vector<int>& crossed) const {
+    corners.assign(1, cells.front());
+    crossed.assign(1, cells.front());
+
+    std::vector<int> segment;
+    std::vector<int> best;
+    size_t anchor = 0;
+    while (anchor + 1 < cells.size()) {
+        // Neighbouring cells on the path are always one valid step apart.
+        size_t next = anchor + 1;
+        best.assign(1, cells[next]);
+        // Open ground usually sees the goal directly; try that before scanning.
+        segment.clear();
+        if (next + 1 < cells.size() && hasLineOfSight(cells[anchor], cells.back(), segment)) {
+            crossed.insert(crossed.end(), segment.begin(), segment.end());
+            corners.push_back(cells.back());
+            break;
+        }
+        for (size_t i = anchor + 2; i < cells.size(); ++i) {
+            segment.clear();
+            if (!hasLineOfSight(cells[anchor], cells[i], segment)) {
+                break;
+            }
+            next = i;
+            best.swap(segment);
+        }
+        crossed.insert(crossed.end(), best.begin(), best.end());
+        corners.push_back(cells[next]);
+        anchor = next;
+    }
+}
+
+void NavGraph::sampleCells(const Terrain& terrain, int x0, int z0, int x1, int z1) {
+    const float inset = m_cellSize * 0.35f;
+    const glm::vec2 offsets[] = {{0.0f, 0.0f}, {-inset, -inset}, {inset, -inset}, {-inset, inset}, {inset, inset}};
+
+    for (int z = z0; z < z1; ++z) {
+        for (int x = x0; x < x1; ++x) {
+            const float cx = m_origin.x + (static_cast<float>(x) + 0.5f) * m_cellSize;
+            const float cz = m_origin.y + (static_cast<float>(z) + 0.5f) * m_cellSize;
+
+            bool walkable = true;
+            float height = 0.0f;
+            for (const glm::vec2& offset : offsets) {
+                const std::optional<SurfaceHit> hit = terrain.sampleSurface(cx + offset.x, cz + offset.y);
+                if (!hit.has_value() || !PlayerController::isWalkableNormal(hit->normal)) {
+                    walkable = false;
+                    break;
+                }
+                if (offset.x == 0.0f && offset.y == 0.0f) {
+                    height = hit->y;
+                }
+            }
+
+            const auto cell = static_cast<size_t>(cellIndex(x, z));
+            m_walkable[cell] = walkable ? 1 : 0;
+            m_height[cell] = height;
+        }
+    }
+}
+
+void NavGraph::addBorderEntrances(Cluster& cluster, int dx, int dz) {
+    // Cells along the border on our side, and the neighbour cell across it.
+    const bool vertical = dx != 0;
+    const int fixed = dx > 0 ? cluster.x1 - 1 : dx < 0 ? cluster.x0 : dz > 0 ? cluster.z1 - 1 : cluster.z0;
+    const int across = fixed + (vertical ? dx : dz);
+    if (across < 0 || across >= (vertical ? m_cellsX : m_cellsZ)) {
+        return;
+    }
+
+    const int begin = vertical ? cluster.z0 : cluster.x0;
+    const int end = vertical ? cluster.z1 : cluster.x1;
+
+    auto insideCell = [&](int t) { return vertical ? cellIndex(fixed, t) : cellIndex(t, fixed); };
+    auto outsideCell = [&](int t) { return vertical ? cellIndex(across, t) : cellIndex(t, across); };
+    auto open = [&](int t) {
+        return m_walkable[static_cast<size_t>(insideCell(t))] && m_walkable[static_cast<size_t>(outsideCell(t))];
+    };
+
+    auto addEntrance = [&](int t) {
+        const int cell = insideCell(t);
+        auto it = std::find(cluster.nodes.begin(), cluster.nodes.end(), cell);
+        size_t node = static_cast<size_t>(it - cluster.nodes.begin());
+        if (it == cluster.nodes.end()) {
+            cluster.nodes.push_back(cell);
+            cluster.partners.emplace_back();
+        }
+        cluster.partners[node].push_back(outsideCell(t));
+    };
+
+    // Both clusters sharing a border scan the same positions, so they agree on
+    // where the entrances are without talking to each other.
+    int t = begin;
+    while (t < end) {
+        if (!open(t)) {
+            ++t;
+            continue;
+        }
+        const int spanStart = t;
+        while (t < end && open(t)) {
+            ++t;
+        }
+        const int length = t - spanStart;
+        if (length > kLongEntrance) {
+            addEntrance(spanStart);
+            addEntrance(t - 1);
+        } else {
+            addEntrance(spanStart + (length - 1) / 2);
+        }
+    }
+}
+
+void NavGraph::buildCluster(Cluster& cluster) {
+    for (int node : cluster.nodes) {
+        m_nodeOfCell[static_cast<size_t>(node)] = -1;
+    }
+    cluster.nodes.clear();
+    cluster.partners.clear();
+
+    addBorderEntrances(cluster, 1, 0);
+    addBorderEntrances(cluster, -1, 0);
+    addBorderEntrances(cluster, 0, 1);
+    addBorderEntrances(cluster, 0, -1);
+
+    const size_t count = cluster.nodes.size();
+    cluster.cost.assign(count * count, kInfinity);
+    cluster.parents.assign(count, {});
+
+    std::vector<float> dist;
+    for (size_t i = 0; i < count; ++i) {
+        m_nodeOfCell[static_cast<size_t>(cluster.nodes[i])] = static_cast<int>(i);
+        localSearch(cluster, cluster.nodes[i], dist, cluster.parents[i]);
+        for (size_t j = 0; j < count; ++j) {
+            cluster.cost[i * count + j] = dist[static_cast<size_t>(localIndex(cluster, cluster.nodes[j]))];
+        }
+    }
+
+    ++cluster.version;
+}
+
+void NavGraph::localSearch(const Cluster& cluster, int sourceCell, std::vector<float>& dist,
+                           std::vector<std::int16_t>& parent) const {
+    const int localCount = cluster.localCount();
+    dist.assign(static_cast<size_t>(localCount), kInfinity);
+    parent.assign(static_cast<size_t>(localCount), -1);
+    if (!m_walkable[static_cast<size_t>(sourceCell)]) {
+        return;
+    }
+
+    MinQueue open;
+    const int source = localIndex(cluster, sourceCell);
+    dist[static_cast<size_t>(source)] = 0.0f;
+    open.push({0.0f, source});
+
+    while (!open.empty()) {
+        const QueueItem item = open.top();
+        open.pop();
+        if (item.priority > dist[static_cast<size_t>(item.cell)]) {
+            continue;
+        }
+
+        const int x = cluster.x0 + item.cell % cluster.width();
+        const int z = cluster.z0 + item.cell / cluster.width();
+        for (int dz = -1; dz <= 1; ++dz) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if ((dx == 0 && dz == 0) || !canStep(x, z, dx, dz)) {
+                    continue;
+                }
+                const int nx = x + dx;
+                const int nz = z + dz;
+                if (nx < cluster.x0 || nz < cluster.z0 || nx >= cluster.x1 || nz >= cluster.z1) {
+                    continue;
+                }
+
+                const int next = (nz - cluster.z0) * cluster.width() + (nx - cluster.x0);
+                const float step = (dx != 0 && dz != 0 ? kDiagonal : 1.0f) * m_cellSize;
+                const float candidate = item.priority + step;
+                if (candidate < dist[static_cast<size_t>(next)]) {
+                    dist[static_cast<size_t>(next)] = candidate;
+                    parent[static_cast<size_t>(next)] = static_cast<std::int16_t>(item.cell);
+                    open.push({candidate, next});
+                }
+            }
+        }
+    }
+}
+
+void NavGraph::appendLocalRoute(const Cluster& cluster, const std::vector<std::int16_t>& parent, int fromCell, bool reverse,
+                                std::vector<int>& cells) const {
+    // Walks the tree from `fromCell` to its root. Forward order ends at the
+    // root; reversed order starts there. The first cell is already in `cells`.
+    std::vector<int> chain;
+    for (int local = localIndex(cluster, fromCell); local >= 0; local = parent[static_cast<size_t>(local)]) {
+        chain.push_back(cellFromLocal(cluster, local));
+    }
+    if (reverse) {
+        std::reverse(chain.begin(), chain.end());
+    }
+    cells.insert(cells.end(), chain.begin() + 1, chain.end());
+}
+
+NavPath NavGraph::search(int startCell, int goalCell) const {
+    SearchScratch& s = t_scratch;
+    s.begin(m_walkable.size());
+
+    const int startClusterIndex = clusterOf(startCell);
+    const int goalClusterIndex = clusterOf(goalCell);
+    const Cluster& startCluster = m_clusters[static_cast<size_t>(startClusterIndex)];
+    const Cluster& goalCluster = m_clusters[static_cast<size_t>(goalClusterIndex)];
+
+    NavPath path;
+    std::vector<int> cells{startCell};
+
+    const int startX = startCell % m_cellsX;
+    const int startZ = startCell / m_cellsX;
+    const int goalX = goalCell % m_cellsX;
+    const int goalZ = goalCell / m_cellsX;
+
+    // Short queries search the grid directly in a window around both ends;
+    // routing them through cluster entrances can produce large detours.
+    if (std::max(std::abs(startX - goalX), std::abs(startZ - goalZ)) <= kClusterSize) {
+        constexpr int margin = kClusterSize / 2;
+        Cluster window;
+        window.x0 = std::max(0, std::min(startX, goalX) - margin);
+        window.z0 = std::max(0, std::min(startZ, goalZ) - margin);
+        window.x1 = std::min(m_cellsX, std::max(startX, goalX) + margin + 1);
+        window.z1 = std::min(m_cellsZ, std::max(startZ, goalZ) + margin + 1);
+
+        localSearch(window, startCell, s.startDist, s.startParent);
+        if (s.startDist[static_cast<size_t>(localIndex(window, goalCell))] < kInfinity) {
+            appendLocalRoute(window, s.startParent, goalCell, true, cells);
+            path.found = true;
+        }
+    }
+
+    if (!path.found) {
+        localSearch(startCluster, startCell, s.startDist, s.startParent);
+        localSearch(goalCluster, goalCell, s.goalDist, s.goalParent);
+
+        auto heuristic = [&](int cell) { return octile(cell % m_cellsX, cell / m_cellsX, goalX, goalZ) * m_cellSize; };
+
+        MinQueue open;
+        auto relax = [&](int from, int to, float cost, Via via) {
+            const auto index = static_cast<size_t>(to);
+            if (s.closed[index] == s.stamp) {
+                return;
+            }
+            const float candidate = s.g[static_cast<size_t>(from)] + cost;
+            if (s.seen[index] != s.stamp || candidate < s.g[index]) {
+                s.seen[index] = s.stamp;
+                s.g[index] = candidate;
+                s.parent[index] = from;
+                s.via[index] = via;
+                open.push({candidate + heuristic(to), to});
+            }
+        };
+
+        s.seen[static_cast<size_t>(startCell)] = s.stamp;
+        s.g[static_cast<size_t>(startCell)] = 0.0f;
+        s.parent[static_cast<size_t>(startCell)] = -1;
+        s.via[static_cast<size_t>(startCell)] = kViaNone;
+        open.push({heuristic(startCell), startCell});
+
+        while (!open.empty()) {
+            const int cell = open.top().cell;
+            open.pop();
+            const auto index = static_cast<size_t>(cell);
+            if (s.closed[index] == s.stamp) {
+                continue;
+            }
+            s.closed[index] = s.stamp;
+
+            if (cell == goalCell) {
+                path.found = true;
+                break;
+            }
+
+            if (cell == startCell) {
+                for (int node : startCluster.nodes) {
+                    const float d = s.startDist[static_cast<size_t>(localIndex(startCluster, node))];
+                    if (d < kInfinity) {
+                        relax(cell, node, d, kViaStart);
+                    }
+                }
+            }
+
+            const int clusterIndex = clusterOf(cell);
+            const Cluster& cluster = m_clusters[static_cast<size_t>(clusterIndex)];
+            const int node = m_nodeOfCell[index];
+            if (node >= 0) {
+                const size_t count = cluster.nodes.size();
+                for (size_t j = 0; j < count; ++j) {
+                    const float cost = cluster.cost[static_cast<size_t>(node) * count + j];
+                    if (cost < kInfinity && static_cast<int>(j) != node) {
+                        relax(cell, cluster.nodes[j], cost, kViaIntra);
+                    }
+                }
+                for (int partner : cluster.partners[static_cast<size_t>(node)]) {
+                    relax(cell, partner, m_cellSize, kViaPartner);
+                }
+            }
+
+            if (clusterIndex == goalClusterIndex) {
+                const float d = s.goalDist[static_cast<size_t>(localIndex(goalCluster, cell))];
+                if (d < kInfinity) {
+                    relax(cell, goalCell, d, kViaGoal);
+                }
+            }
+        }
+
+        if (path.found) {
+            std::vector<int> abstractPath;
+            for (int cell = goalCell; cell >= 0; cell = s.parent[static_cast<size_t>(cell)]) {
+                abstractPath.push_back(cell);
+                if (cell == startCell) {
+                    break;
+                }
+            }
+            std::reverse(abstractPath.begin(), abstractPath.end());
+
+            // Expand each abstract hop into grid cells using the stored routes.
+            for (size_t i = 1; i < abstractPath.size(); ++i) {
+                const int from = abstractPath[i - 1];
+                const int to = abstractPath[i];
+                switch (s.via[static_cast<size_t>(to)]) {
+                    case kViaPartner:
+                        cells.push_back(to);
+                        break;
+                    case kViaStart:
+                        appendLocalRoute(startCluster, s.startParent, to, true, cells);
+                        break;
+                    case kViaIntra: {
+                        const Cluster& cluster = m_clusters[static_cast<size_t>(clusterOf(from))];
+                        appendLocalRoute(cluster, cluster.parents[static_cast<size_t>(m_nodeOfCell[static_cast<size_t>(from)])], to,
+                                         true, cells);
+                        break;
+                    }
+                    case kViaGoal:
+                        appendLocalRoute(goalCluster, s.goalParent, from, false, cells);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    std::vector<int> crossed;
+    if (path.found) {
+        std::vector<int> corners;
+        smoothPath(cells, corners, crossed);
+        path.waypoints.reserve(corners.size());
+        for (int cell : corners) {
+            path.waypoints.push_back(cellCenter(cell));
+        }
+    }
+
+    // Invalidate on the clusters the straightened path crosses, which can differ from the raw route's.
+    storeCache((static_cast<std::uint64_t>(startCell) << 32) | static_cast<std::uint32_t>(goalCell), path, crossed);
+    return path;
+}
+
+bool NavGraph::lookupCache(std::uint64_t key, NavPath& path) const {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    auto it = m_cache.find(key);
+    if (it == m_cache.end()) {
+        return false;
+    }
+
+    const CachedPath& entry = it->second;
+    bool valid = entry.path.found || entry.generation == m_generation;
+    for (const auto& [cluster, version] : entry.clusterVersions) {
+        valid = valid && m_clusters[static_cast<size_t>(cluster)].version == version;
+    }
+    if (!valid) {
+        eraseCacheEntry(it);
+        return false;
+    }
+
+    path = entry.path;
+    return true;
+}
+
+void NavGraph::storeCache(std::uint64_t key, const NavPath& path, const std::vector<int>& cells) const {
+    CachedPath entry;
+    entry.path = path;
+    entry.generation = m_generation;
+    if (path.found) {
+        for (int cell : cells) {
+            const int cluster = clusterOf(cell);
+            if (entry.clusterVersions.empty() || entry.clusterVersions.back().first != cluster) {
+                entry.clusterVersions.emplace_back(cluster, m_clusters[static_cast<size_t>(cluster)].version);
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    if (auto existing = m_cache.find(key); existing != m_cache.end()) {
+        eraseCacheEntry(existing);
+    }
+    while (m_cache.size() >= kCacheCapacity) {
+        eraseCacheEntry(m_cache.find(m_cacheOrder.front()));
+    }
+    entry.order = m_cacheOrder.insert(m_cacheOrder.end(), key);
+    m_cache.emplace(key, std::move(entry));
+}
+
+void NavGraph::eraseCacheEntry(std::unordered_map<std::uint64_t, CachedPath>::iterator it) const {
+    m_cacheOrder.erase(it->second.order);
+    m_cache.erase(it);
+}
+
+NavPath NavGraph::findPath(const glm::vec3& start, const glm::vec3& goal) const {
+    std::shared_lock<std::shared_mutex> lock(m_graphMutex);
+
+    const int startCell = nearestWalkable(cellAt(start));
+    const int goalCell = nearestWalkable(cellAt(goal));
+    if (startCell < 0 || goalCell < 0) {
+        return {};
+    }
+
+    NavPath path;
+    const std::uint64_t key = (static_cast<std::uint64_t>(startCell) << 32) | static_cast<std::uint32_t>(goalCell);
+    if (lookupCache(key, path)) {
+        m_cacheHits.fetch_add(1, std::memory_order_relaxed);
+        return path;
+    }
+
+    m_cacheMisses.fetch_add(1, std::memory_order_relaxed);
+    return search(startCell, goalCell);
+}
+
+std::future<NavPath> NavGraph::findPathAsync(const glm::vec3& start, const glm::vec3& goal) const {
+    auto promise = std::make_shared<std::promise<NavPath>>();
+    std::future<NavPath> result = promise->get_future();
+    m_workers.submit([this, promise, start, goal] {
+        try {
+            promise->set_value(findPath(start, goal));
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return result;
+}
+
+void NavGraph::findPaths(const std::vector<NavQuery>& queries, std::vector<NavPath>& results) const {
+    results.resize(queries.size());
+    m_workers.parallelFor(queries.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            results[i] = findPath(queries[i].start, queries[i].goal);
+        }
+    });
+}
+
+void NavGraph::rebuildRegion(const Terrain& terrain, const glm::vec2& minXZ, const glm::vec2& maxXZ) {
+    std::unique_lock<std::shared_mutex> lock(m_graphMutex);
+
+    const int x0 = std::clamp(static_cast<int>(std::floor((minXZ.x - m_origin.x) / m_cellSize)), 0, m_cellsX - 1);
+    const int z0 = std::clamp(static_cast<int>(std::floor((minXZ.y - m_origin.y) / m_cellSize)), 0, m_cellsZ - 1);
+    const int x1 = std::clamp(static_cast<int>(std::floor((maxXZ.x - m_origin.x) / m_cellSize)), 0, m_cellsX - 1);
+    const int z1 = std::clamp(static_cast<int>(std::floor((maxXZ.y - m_origin.y) / m_cellSize)), 0, m_cellsZ - 1);
+    sampleCells(terrain, x0, z0, x1 + 1, z1 + 1);
+
+    // Neighbours share the changed borders, so their entrances and routes are
+    // rebuilt too; clusters further out cannot be affected.
+    const int cx0 = std::max(0, x0 / kClusterSize - 1);
+    const int cz0 = std::max(0, z0 / kClusterSize - 1);
+    const int cx1 = std::min(m_clustersX - 1, x1 / kClusterSize + 1);
+    const int cz1 = std::min(m_clustersZ - 1, z1 / kClusterSize + 1);
+    for (int cz = cz0; cz <= cz1; ++cz) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            buildCluster(m_clusters[static_cast<size_t>(cz * m_clustersX + cx)]);
+        }
+    }
+
+    ++m_generation;
+}
+
+bool NavGraph::isWalkable(const glm::vec3& position) const {
+    std::shared_lock<std::shared_mutex> lock(m_graphMutex);
+    const int cell = cellAt(position);
+    return cell >= 0 && m_walkable[static_cast<size_t>(cell)];
+}
+
+NavCacheStats NavGraph::cacheStats() const {
+    NavCacheStats stats;
+    stats.hits = m_cacheHits.load(std::memory_order_relaxed);
+    stats.misses = m_cacheMisses.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    stats.entries = m_cache.size();
+    stats.orderEntries = m_cacheOrder.size();
+    return stats;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "WorkerPool.hpp"
+
+class Terrain;
+
+struct NavPath {
+    bool found = false;
+    std::vector<glm::vec3> waypoints;
+};
+
+struct NavQuery {
+    glm::vec3 start{0.0f};
+    glm::vec3 goal{0.0f};
+};
+
+struct NavCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::size_t entries = 0;
+    // Length of the eviction list; always equals `entries`.
+    std::size_t orderEntries = 0;
+};
+
+// Walkability grid sampled from the terrain with the same slope rule the
+// player uses, abstracted into square clusters for hierarchical A* (HPA*).
+// Cluster borders are linked through entrance cells; the cost and route
+// between every pair of entrances inside a cluster is precomputed, so a
+// query only searches the small abstract graph and then stitches the stored
+// routes together. The stitched route is string-pulled with line-of-sight
+// checks, so waypoints are corners rather than every cell and the detour
+// through entrance cells is straightened out. Queries are thread-safe and
+// run concurrently under a shared lock; rebuildRegion() takes that lock
+// exclusively, so queries wait while it rebuilds the affected clusters.
+// Async and batched queries run on the graph's own small pool, so they never
+// queue ahead of the per-frame jobs on the shared WorkerPool.
+class NavGraph {
+public:
+    static constexpr int kClusterSize = 8;
+    static constexpr unsigned int kDefaultWorkerThreads = 2;
+
+    // `cellSize` <= 0 picks half the terrain's own cell spacing.
+    explicit NavGraph(const Terrain& terrain, float cellSize = 0.0f, unsigned int workerThreads = kDefaultWorkerThreads);
+
+    NavGraph(const NavGraph&) = delete;
+    NavGraph& operator=(const NavGraph&) = delete;
+
+    [[nodiscard]] NavPath findPath(const glm::vec3& start, const glm::vec3& goal) const;
+    [[nodiscard]] std::future<NavPath> findPathAsync(const glm::vec3& start, const glm::vec3& goal) const;
+    // Answers a batch of queries across the graph's pool and the calling
+    // thread; `results` matches `queries` by index. It blocks until the batch
+    // is done, so don't call it from a WorkerPool job.
+    void findPaths(const std::vector<NavQuery>& queries, std::vector<NavPath>& results) const;
+
+    // Re-samples the cells overlapping the XZ rectangle and rebuilds only the
+    // clusters whose entrances or routes can have changed.
+    void rebuildRegion(const Terrain& terrain, const glm::vec2& minXZ, const glm::vec2& maxXZ);
+
+    [[nodiscard]] bool isWalkable(const glm::vec3& position) const;
+    NavCacheStats cacheStats() const;
+
+private:
+    struct Cluster {
+        int x0 = 0;
+        int z0 = 0;
+        int x1 = 0;  // exclusive
+        int z1 = 0;  // exclusive
+        std::uint32_t version = 0;
+
+        // Entrance cells inside this cluster and the cells across the border they connect to.
+        std::vector<int> nodes;
+        std::vector<std::vector<int>> partners;
+        // nodes.size()^2 route costs; infinity when unreachable inside the cluster.
+        std::vector<float> cost;
+        // Per node: shortest-path tree over the cluster's local cells, rooted at that node.
+        std::vector<std::vector<std::int16_t>> parents;
+
+        int width() const { return x1 - x0; }
+        int localCount() const { return (x1 - x0) * (z1 - z0); }
+    };
+
+    struct CachedPath {
+        NavPath path;
+        std::uint32_t generation = 0;
+        std::vector<std::pair<int, std::uint32_t>> clusterVersions;
+        // This entry's key in m_cacheOrder, so dropping the entry drops its key too.
+        std::list<std::uint64_t>::iterator order;
+    };
+
+    static constexpr std::size_t kCacheCapacity = 4096;
+
+    int m_cellsX = 0;
+    int m_cellsZ = 0;
+    float m_cellSize = 1.0f;
+    glm::vec2 m_origin{0.0f};
+
+    std::vector<std::uint8_t> m_walkable;
+    std::vector<float> m_height;
+
+    int m_clustersX = 0;
+    int m_clustersZ = 0;
+    std::vector<Cluster> m_clusters;
+    // Local node index of each cell inside its cluster, or -1.
+    std::vector<int> m_nodeOfCell;
+    std::uint32_t m_generation = 0;
+
+    mutable std::shared_mutex m_graphMutex;
+
+    mutable std::mutex m_cacheMutex;
+    mutable std::unordered_map<std::uint64_t, CachedPath> m_cache;
+    // Insertion order, oldest first; holds exactly the keys in m_cache.
+    mutable std::list<std::uint64_t> m_cacheOrder;
+    mutable std::atomic<std::uint64_t> m_cacheHits{0};
+    mutable std::atomic<std::uint64_t> m_cacheMisses{0};
+
+    // Declared last so it drains and joins before the graph it reads goes away.
+    mutable WorkerPool m_workers;
+
+    int cellIndex(int x, int z) const { return z * m_cellsX + x; }
+    int clusterOf(int cell) const;
+    int localIndex(const Cluster& cluster, int cell) const;
+    int cellFromLocal(const Cluster& cluster, int local) const;
+    glm::vec3 cellCenter(int cell) const;
+    int cellAt(const glm::vec3& position) const;
+    int nearestWalkable(int cell) const;
+    bool canStep(int fromX, int fromZ, int dx, int dz) const;
+    // True when the segment between the two cell centres only crosses cells a
+    // sequence of canStep() moves could visit; the crossed cells are appended.
+    bool hasLineOfSight(int fromCell, int toCell, std::vector<int>& crossed) const;
+    // String-pulls a cell path into its corner cells; `crossed` receives every
+    // cell the straightened path passes through.
+    void smoothPath(const std::vector<int>& cells, std::vector<int>& corners, std::vector<int>& crossed) const;
+
+    void sampleCells(const Terrain& terrain, int x0, int z0, int x1, int z1);
+    void buildCluster(Cluster& cluster);
+    void addBorderEntrances(Cluster& cluster, int dx, int dz);
+    void localSearch(const Cluster& cluster, int sourceCell, std::vector<float>& dist, std::vector<std::int16_t>& parent) const;
+    void appendLocalRoute(const Cluster& cluster, const std::vector<std::int16_t>& parent, int fromCell, bool reverse,
+                          std::vector<int>& cells) const;
+
+    NavPath search(int startCell, int goalCell) const;
+    bool lookupCache(std::uint64_t key, NavPath& path) const;
+    void storeCache(std::uint64_t key, const NavPath& path, const std::vector<int>& cells) const;
+    void eraseCacheEntry(std::unordered_map<std::uint64_t, CachedPath>::iterator it) const;
+};
@@ -0,0 +1,273 @@
+#include "OcclusionCuller.hpp"
+
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MINI_FPS_OCCLUSION_SSE 1
+#endif
+
+namespace {
+// Matches the renderer's near plane; anything closer is treated as visible
+// rather than clipped.
+constexpr float kNearW = 0.1f;
+constexpr int kBandRows = 16;
+constexpr std::size_t kParallelBoxThreshold = 256;
+
+static_assert(OcclusionCuller::kWidth % 4 == 0, "rasterizer processes four pixels at a time");
+static_assert(OcclusionCuller::kHeight % kBandRows == 0, "bands must tile the depth buffer");
+}  // namespace
+
+OcclusionCuller::OcclusionCuller(WorkerPool& workers) : m_workers(workers) {
+    int w = kWidth;
+    int h = kHeight;
+    for (;;) {
+        m_pyramid.emplace_back(static_cast<size_t>(w * h), 1.0f);
+        if (w == 1 || h == 1) {
+            break;
+        }
+        w /= 2;
+        h /= 2;
+    }
+}
+
+void OcclusionCuller::setOccluders(std::vector<glm::vec3> positions, std::vector<unsigned int> indices) {
+    m_occluderPositions = std::move(positions);
+    m_occluderIndices = std::move(indices);
+    m_projected.resize(m_occluderPositions.size());
+}
+
+void OcclusionCuller::cull(const glm::mat4& viewProj, const std::vector<Aabb>& boxes, std::vector<std::uint8_t>& visible) {
+    const auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < m_occluderPositions.size(); ++i) {
+        const glm::vec4 clip = viewProj * glm::vec4(m_occluderPositions[i], 1.0f);
+        ScreenVertex& v = m_projected[i];
+        v.valid = clip.w > kNearW;
+        if (!v.valid) {
+            continue;
+        }
+        const float invW = 1.0f / clip.w;
+        v.x = (clip.x * invW * 0.5f + 0.5f) * static_cast<float>(kWidth);
+        v.y = (clip.y * invW * 0.5f + 0.5f) * static_cast<float>(kHeight);
+        v.z = clip.z * invW * 0.5f + 0.5f;
+    }
+
+    m_workers.parallelFor(kHeight / kBandRows, [this](size_t begin, size_t end) {
+        for (size_t band = begin; band < end; ++band) {
+            rasterizeBand(static_cast<int>(band) * kBandRows, static_cast<int>(band + 1) * kBandRows);
+        }
+    });
+
+    buildPyramid();
+
+    visible.assign(boxes.size(), 1);
+    std::vector<BoxResult> results(boxes.size(), BoxResult::Visible);
+    auto testRange = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            results[i] = testBox(viewProj, boxes[i]);
+        }
+    };
+    if (boxes.size() > kParallelBoxThreshold) {
+        m_workers.parallelFor(boxes.size(), testRange);
+    } else {
+        testRange(0, boxes.size());
+    }
+
+    m_stats = OcclusionStats{};
+    m_stats.tested = static_cast<int>(boxes.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i] == BoxResult::Occluded) {
+            ++m_stats.occluded;
+            visible[i] = 0;
+        } else if (results[i] == BoxResult::Offscreen) {
+            ++m_stats.offscreen;
+            visible[i] = 0;
+        }
+    }
+    m_stats.hitRate = m_stats.tested > 0 ? static_cast<float>(m_stats.occluded) / static_cast<float>(m_stats.tested) : 0.0f;
+    m_stats.cullMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void OcclusionCuller::rasterizeBand(int rowBegin, int rowEnd) {
+    std::vector<float>& depth = m_pyramid[0];
+    std::fill(depth.begin() + rowBegin * kWidth, depth.begin() + rowEnd * kWidth, 1.0f);
+
+    for (size_t i = 0; i + 2 < m_occluderIndices.size(); i += 3) {
+        const ScreenVertex& a = m_projected[m_occluderIndices[i + 0]];
+        const ScreenVertex& b = m_projected[m_occluderIndices[i + 1]];
+        const ScreenVertex& c = m_projected[m_occluderIndices[i + 2]];
+        if (!a.valid || !b.valid || !c.valid) {
+            // Dropping an occluder only makes culling less aggressive, never wrong.
+            continue;
+        }
+        rasterizeTriangle(a, b, c, rowBegin, rowEnd);
+    }
+}
+
+void OcclusionCuller::rasterizeTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c, int rowBegin,
+                                        int rowEnd) {
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    const ScreenVertex* v0 = &a;
+    const ScreenVertex* v1 = &b;
+    const ScreenVertex* v2 = &c;
+    if (area < 0.0f) {
+        // Occluders are double sided; flip to counter-clockwise.
+        std::swap(v1, v2);
+        area = -area;
+    }
+    if (area < 1e-6f) {
+        return;
+    }
+
+    const int minY = std::max(rowBegin, static_cast<int>(std::floor(std::min({v0->y, v1->y, v2->y}))));
+    const int maxY = std::min(rowEnd - 1, static_cast<int>(std::ceil(std::max({v0->y, v1->y, v2->y}))));
+    int minX = std::max(0, static_cast<int>(std::floor(std::min({v0->x, v1->x, v2->x}))));
+    const int maxX = std::min(kWidth - 1, static_cast<int>(std::ceil(std::max({v0->x, v1->x, v2->x}))));
+    if (minY > maxY || minX > maxX) {
+        return;
+    }
+    minX &= ~3;
+
+    // Edge functions E(x, y) = A*x + B*y + C, positive inside. Edge i is the
+    // one opposite vertex i, so E_i / area is that vertex's barycentric weight.
+    auto edge = [](const ScreenVertex& p, const ScreenVertex& q, float& A, float& B, float& C) {
+        A = -(q.y - p.y);
+        B = q.x - p.x;
+        C = -(q.x - p.x) * p.y + (q.y - p.y) * p.x;
+    };
+    float A0, B0, C0, A1, B1, C1, A2, B2, C2;
+    edge(*v1, *v2, A0, B0, C0);
+    edge(*v2, *v0, A1, B1, C1);
+    edge(*v0, *v1, A2, B2, C2);
+
+    const float invArea = 1.0f / area;
+    const float zA = (A0 * v0->z + A1 * v1->z + A2 * v2->z) * invArea;
+    const float zB = (B0 * v0->z + B1 * v1->z + B2 * v2->z) * invArea;
+    const float zC = (C0 * v0->z + C1 * v1->z + C2 * v2->z) * invArea;
+
+    float* depth = m_pyramid[0].data();
+
+#ifdef MINI_FPS_OCCLUSION_SSE
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 a0 = _mm_set1_ps(A0);
+    const __m128 a1 = _mm_set1_ps(A1);
+    const __m128 a2 = _mm_set1_ps(A2);
+    const __m128 az = _mm_set1_ps(zA);
+
+    for (int y = minY; y <= maxY; ++y) {
+        const float py = static_cast<float>(y) + 0.5f;
+        const __m128 row0 = _mm_set1_ps(B0 * py + C0);
+        const __m128 row1 = _mm_set1_ps(B1 * py + C1);
+        const __m128 row2 = _mm_set1_ps(B2 * py + C2);
+        const __m128 rowZ = _mm_set1_ps(zB * py + zC);
+        float* line = depth + y * kWidth;
+
+        for (int x = minX; x <= maxX; x += 4) {
+            const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lanes);
+            const __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), row0);
+            const __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), row1);
+            const __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), row2);
+            const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+            if (_mm_movemask_ps(inside) == 0) {
+                continue;
+            }
+
+            const __m128 z = _mm_add_ps(_mm_mul_ps(az, px), rowZ);
+            const __m128 old = _mm_loadu_ps(line + x);
+            const __m128 nearer = _mm_min_ps(old, z);
+            _mm_storeu_ps(line + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+        }
+    }
+#else
+    for (int y = minY; y <= maxY; ++y) {
+        const float py = static_cast<float>(y) + 0.5f;
+        float* line = depth + y * kWidth;
+        for (int x = minX; x <= maxX; ++x) {
+            const float px = static_cast<float>(x) + 0.5f;
+            if (A0 * px + B0 * py + C0 < 0.0f || A1 * px + B1 * py + C1 < 0.0f || A2 * px + B2 * py + C2 < 0.0f) {
+                continue;
+            }
+            line[x] = std::min(line[x], zA * px + zB * py + zC);
+        }
+    }
+#endif
+}
+
+void OcclusionCuller::buildPyramid() {
+    int w = kWidth;
+    int h = kHeight;
+    for (size_t level = 1; level < m_pyramid.size(); ++level) {
+        const std::vector<float>& src = m_pyramid[level - 1];
+        std::vector<float>& dst = m_pyramid[level];
+        const int srcW = w;
+        w /= 2;
+        h /= 2;
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                const float* top = &src[static_cast<size_t>((2 * y) * srcW + 2 * x)];
+                const float* bottom = top + srcW;
+                dst[static_cast<size_t>(y * w + x)] = std::max(std::max(top[0], top[1]), std::max(bottom[0], bottom[1]));
+            }
+        }
+    }
+}
+
+OcclusionCuller::BoxResult OcclusionCuller::testBox(const glm::mat4& viewProj, const Aabb& box) const {
+    float minX = 1e30f;
+    float minY = 1e30f;
+    float maxX = -1e30f;
+    float maxY = -1e30f;
+    float minZ = 1e30f;
+
+    for (int i = 0; i < 8; ++i) {
+        const glm::vec3 corner((i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y,
+                               (i & 4) ? box.max.z : box.min.z);
+        const glm::vec4 clip = viewProj * glm::vec4(corner, 1.0f);
+        if (clip.w <= kNearW) {
+            return BoxResult::Visible;
+        }
+        const float invW = 1.0f / clip.w;
+        minX = std::min(minX, clip.x * invW);
+        maxX = std::max(maxX, clip.x * invW);
+        minY = std::min(minY, clip.y * invW);
+        maxY = std::max(maxY, clip.y * invW);
+        minZ = std::min(minZ, clip.z * invW);
+    }
+
+    if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f || minZ > 1.0f) {
+        return BoxResult::Offscreen;
+    }
+
+    auto toPixel = [](float ndc, int size) {
+        return std::clamp(static_cast<int>((ndc * 0.5f + 0.5f) * static_cast<float>(size)), 0, size - 1);
+    };
+    const int px0 = toPixel(minX, kWidth);
+    const int px1 = toPixel(maxX, kWidth);
+    const int py0 = toPixel(minY, kHeight);
+    const int py1 = toPixel(maxY, kHeight);
+
+    // Pick the level where the rectangle spans at most a few texels.
+    const int extent = std::max(px1 - px0, py1 - py0) + 1;
+    int level = 0;
+    while ((extent >> level) > 2 && level + 1 < static_cast<int>(m_pyramid.size())) {
+        ++level;
+    }
+
+    const int levelW = kWidth >> level;
+    const std::vector<float>& texels = m_pyramid[static_cast<size_t>(level)];
+    float farthest = 0.0f;
+    for (int y = py0 >> level; y <= (py1 >> level); ++y) {
+        for (int x = px0 >> level; x <= (px1 >> level); ++x) {
+            farthest = std::max(farthest, texels[static_cast<size_t>(y * levelW + x)]);
+        }
+    }
+
+    const float boxDepth = minZ * 0.5f + 0.5f;
+    return boxDepth > farthest ? BoxResult::Occluded : BoxResult::Visible;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "Bounds.hpp"
+
+class WorkerPool;
+
+struct OcclusionStats {
+    int tested = 0;
+    int occluded = 0;
+    int offscreen = 0;
+    float hitRate = 0.0f;  // occluded / tested
+    float cullMs = 0.0f;
+};
+
+// Software hierarchical-Z culler. Occluder triangles are rasterized into a
+// small depth buffer (in horizontal bands spread across the worker pool), a
+// max-depth pyramid is built on top, and boxes are rejected when their
+// nearest point lies behind everything the pyramid has recorded.
+class OcclusionCuller {
+public:
+    static constexpr int kWidth = 256;
+    static constexpr int kHeight = 128;
+
+    explicit OcclusionCuller(WorkerPool& workers);
+
+    void setOccluders(std::vector<glm::vec3> positions, std::vector<unsigned int> indices);
+
+    // Writes 1 to `visible[i]` when `boxes[i]` may be visible, 0 when hidden.
+    void cull(const glm::mat4& viewProj, const std::vector<Aabb>& boxes, std::vector<std::uint8_t>& visible);
+
+    const OcclusionStats& stats() const { return m_stats; }
+
+private:
+    enum class BoxResult { Visible, Occluded, Offscreen };
+
+    struct ScreenVertex {
+        float x;
+        float y;
+        float z;
+        bool valid;
+    };
+
+    WorkerPool& m_workers;
+
+    std::vector<glm::vec3> m_occluderPositions;
+    std::vector<unsigned int> m_occluderIndices;
+    std::vector<ScreenVertex> m_projected;
+
+    // Level 0 is the rasterized depth buffer; each further level halves both
+    // dimensions and keeps the farthest depth of the 2x2 texels beneath it.
+    std::vector<std::vector<float>> m_pyramid;
+
+    OcclusionStats m_stats;
+
+    void rasterizeBand(int rowBegin, int rowEnd);
+    void rasterizeTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c, int rowBegin, int rowEnd);
+    void buildPyramid();
+    BoxResult testBox(const glm::mat4& viewProj, const Aabb& box) const;
+};
@@ -0,0 +1,352 @@
+#include "ParticleSystem.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace {
+constexpr float kGravity = 20.0f;
+constexpr float kDustPerSecond = 90.0f;
+constexpr float kWeatherRadius = 24.0f;
+constexpr float kWeatherHeight = 14.0f;
+
+constexpr std::size_t kParticleStride = sizeof(glm::vec4) * 2 + sizeof(glm::vec2);
+
+// `firstParticle` offsets the pointers; GL 4.1 has no base instance for instanced draws.
+void setParticleAttributes(GLuint firstLocation, GLuint divisor, GLsizei firstParticle = 0) {
+    const auto stride = static_cast<GLsizei>(kParticleStride);
+    const std::size_t base = static_cast<std::size_t>(firstParticle) * kParticleStride;
+    glEnableVertexAttribArray(firstLocation);
+    glVertexAttribPointer(firstLocation, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(base));
+    glVertexAttribDivisor(firstLocation, divisor);
+
+    glEnableVertexAttribArray(firstLocation + 1);
+    glVertexAttribPointer(firstLocation + 1, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(base + sizeof(glm::vec4)));
+    glVertexAttribDivisor(firstLocation + 1, divisor);
+
+    glEnableVertexAttribArray(firstLocation + 2);
+    glVertexAttribPointer(firstLocation + 2, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(base + sizeof(glm::vec4) * 2));
+    glVertexAttribDivisor(firstLocation + 2, divisor);
+}
+}  // namespace
+
+ParticleSystem::ParticleSystem(GLsizei capacity) : m_capacity(capacity) {
+    static_assert(sizeof(GpuParticle) == kParticleStride,
+                  "GpuParticle must match the tightly packed transform feedback layout");
+
+    const char* updateShader = R"(
+        #version 410 core
+        layout(location = 0) in vec4 aPositionAge;
+        layout(location = 1) in vec4 aVelocityLifetime;
+        layout(location = 2) in vec2 aSizeKind;
+
+        out vec4 tfPositionAge;
+        out vec4 tfVelocityLifetime;
+        out vec2 tfSizeKind;
+
+        uniform float uDt;
+        uniform float uGravity;
+        uniform vec3 uWind;
+
+        void main() {
+            vec3 position = aPositionAge.xyz;
+            vec3 velocity = aVelocityLifetime.xyz;
+            float age = aPositionAge.w;
+
+            if (age < aVelocityLifetime.w) {
+                bool rain = aSizeKind.y > 1.5;
+                // Dust hangs in the air; rain falls at full gravity.
+                float gravityScale = rain ? 1.0 : 0.15;
+                float drag = rain ? 0.0 : 2.5;
+                velocity += (vec3(0.0, -uGravity * gravityScale, 0.0) + uWind * (rain ? 0.4 : 1.0)) * uDt;
+                velocity /= 1.0 + drag * uDt;
+                position += velocity * uDt;
+                age += uDt;
+            }
+
+            tfPositionAge = vec4(position, age);
+            tfVelocityLifetime = vec4(velocity, aVelocityLifetime.w);
+            tfSizeKind = aSizeKind;
+        }
+    )";
+
+    const char* renderVertexShader = R"(
+        #version 410 core
+        layout(location = 0) in vec2 aCorner;
+        layout(location = 1) in vec4 aPositionAge;
+        layout(location = 2) in vec4 aVelocityLifetime;
+        layout(location = 3) in vec2 aSizeKind;
+
+        out vec2 vCorner;
+        out vec4 vColor;
+        flat out int vRain;
+
+        uniform mat4 uView;
+        uniform mat4 uProj;
+
+        void main() {
+            vCorner = aCorner;
+            vRain = aSizeKind.y > 1.5 ? 1 : 0;
+
+            if (aPositionAge.w >= aVelocityLifetime.w) {
+                // Dead: collapse outside the clip volume.
+                vColor = vec4(0.0);
+                gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+                return;
+            }
+
+            float t = aPositionAge.w / aVelocityLifetime.w;
+            vec3 right = vec3(uView[0][0], uView[1][0], uView[2][0]);
+            vec3 up = vec3(uView[0][1], uView[1][1], uView[2][1]);
+
+            vec3 offset;
+            if (vRain == 1) {
+                // Streak along the fall direction.
+                vec3 dir = normalize(aVelocityLifetime.xyz);
+                offset = right * aCorner.x * aSizeKind.x * 0.08 + dir * aCorner.y * aSizeKind.x;
+                vColor = vec4(0.72, 0.78, 0.88, 0.35);
+            } else {
+                float size = aSizeKind.x * mix(0.6, 1.8, t);
+                offset = (right * aCorner.x + up * aCorner.y) * size;
+                float strength = aSizeKind.y > 0.5 ? 0.55 : 0.35;
+                vColor = vec4(0.56, 0.48, 0.37, strength * (1.0 - t));
+            }
+
+            gl_Position = uProj * uView * vec4(aPositionAge.xyz + offset, 1.0);
+        }
+    )";
+
+    const char* renderFragmentShader = R"(
+        #version 410 core
+        in vec2 vCorner;
+        in vec4 vColor;
+        flat in int vRain;
+
+        out vec4 FragColor;
+
+        void main() {
+            float falloff = vRain == 1 ? 1.0 - abs(vCorner.x) : 1.0 - smoothstep(0.4, 1.0, length(vCorner));
+            float alpha = vColor.a * falloff;
+            if (alpha <= 0.003) {
+                discard;
+            }
+            FragColor = vec4(vColor.rgb, alpha);
+        }
+    )";
+
+    m_updateShader = std::make_unique<Shader>(
+        updateShader, std::vector<const char*>{"tfPositionAge", "tfVelocityLifetime", "tfSizeKind"});
+    m_renderShader = std::make_unique<Shader>(renderVertexShader, renderFragmentShader);
+
+    // Zeroed particles have age == lifetime == 0, i.e. they start out dead.
+    const std::vector<GpuParticle> zeroes(static_cast<size_t>(m_capacity), GpuParticle{});
+    glGenBuffers(2, m_buffers.data());
+    for (GLuint buffer : m_buffers) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(zeroes.size() * sizeof(GpuParticle)), zeroes.data(), GL_DYNAMIC_COPY);
+    }
+
+    const float corners[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+    glGenBuffers(1, &m_quadVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, m_quadVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &m_emitBuffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, m_emitBuffer);
+    glBufferData(GL_COPY_READ_BUFFER, static_cast<GLsizeiptr>(kMaxEmitPerFrame * sizeof(GpuParticle)), nullptr, GL_STREAM_DRAW);
+
+    glGenVertexArrays(2, m_updateVaos.data());
+    glGenVertexArrays(2, m_renderVaos.data());
+    for (size_t i = 0; i < 2; ++i) {
+        glBindVertexArray(m_updateVaos[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, m_buffers[i]);
+        setParticleAttributes(0, 0);
+
+        glBindVertexArray(m_renderVaos[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, m_quadVbo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, nullptr);
+        glBindBuffer(GL_ARRAY_BUFFER, m_buffers[i]);
+        setParticleAttributes(1, 1);
+    }
+    glBindVertexArray(0);
+
+    m_pending.reserve(kMaxEmitPerFrame);
+}
+
+ParticleSystem::~ParticleSystem() {
+    glDeleteVertexArrays(2, m_renderVaos.data());
+    glDeleteVertexArrays(2, m_updateVaos.data());
+    glDeleteBuffers(2, m_buffers.data());
+    if (m_quadVbo) glDeleteBuffers(1, &m_quadVbo);
+    if (m_emitBuffer) glDeleteBuffers(1, &m_emitBuffer);
+}
+
+float ParticleSystem::random(float lo, float hi) {
+    return std::uniform_real_distribution<float>(lo, hi)(m_rng);
+}
+
+void ParticleSystem::emit(ParticleKind kind, const glm::vec3& position, const glm::vec3& velocity, float lifetime, float size) {
+    if (m_pending.size() >= static_cast<size_t>(std::min(kMaxEmitPerFrame, m_capacity))) {
+        return;
+    }
+    GpuParticle particle;
+    particle.positionAge = glm::vec4(position, 0.0f);
+    particle.velocityLifetime = glm::vec4(velocity, std::min(lifetime, kMaxLifetime));
+    particle.sizeKind = glm::vec2(size, static_cast<float>(kind));
+    m_pending.push_back(particle);
+}
+
+void ParticleSystem::emitDustTrail(const glm::vec3& feet, const glm::vec3& velocity, float dt) {
+    m_dustCarry += kDustPerSecond * dt;
+    const glm::vec3 backwards = -0.15f * glm::vec3(velocity.x, 0.0f, velocity.z);
+    for (; m_dustCarry >= 1.0f; m_dustCarry -= 1.0f) {
+        const glm::vec3 jitter(random(-0.25f, 0.25f), random(0.0f, 0.1f), random(-0.25f, 0.25f));
+        const glm::vec3 kick(random(-0.6f, 0.6f), random(0.4f, 1.2f), random(-0.6f, 0.6f));
+        emit(ParticleKind::Dust, feet + jitter, backwards + kick, random(0.6f, 1.1f), random(0.12f, 0.22f));
+    }
+}
+
+void ParticleSystem::emitLandingImpact(const glm::vec3& feet, float impactSpeed) {
+    const int count = std::min(96, static_cast<int>(impactSpeed * 6.0f));
+    for (int i = 0; i < count; ++i) {
+        const float angle = random(0.0f, 6.2831853f);
+        const float speed = random(0.5f, 1.0f) * impactSpeed * 0.35f;
+        const glm::vec3 velocity(std::cos(angle) * speed, random(0.3f, 1.0f) * impactSpeed * 0.12f, std::sin(angle) * speed);
+        emit(ParticleKind::Impact, feet + glm::vec3(0.0f, 0.05f, 0.0f), velocity, random(0.5f, 0.9f), random(0.15f, 0.3f));
+    }
+}
+
+void ParticleSystem::emitWeather(const glm::vec3& cameraPos, float dt) {
+    m_weatherCarry += m_weatherRate * dt;
+    for (; m_weatherCarry >= 1.0f; m_weatherCarry -= 1.0f) {
+        const glm::vec3 spawn = cameraPos + glm::vec3(random(-kWeatherRadius, kWeatherRadius), random(kWeatherHeight * 0.5f, kWeatherHeight),
+                                                      random(-kWeatherRadius, kWeatherRadius));
+        const glm::vec3 velocity(m_wind.x, -random(11.0f, 14.0f), m_wind.z);
+        emit(ParticleKind::Rain, spawn, velocity, 1.4f, random(0.25f, 0.4f));
+    }
+}
+
+void ParticleSystem::appendPending(GLuint destination) {
+    const auto count = static_cast<GLsizei>(m_pending.size());
+    if (count == 0) {
+        return;
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, m_emitBuffer);
+    // Orphan so the upload never waits on last frame's copy.
+    glBufferData(GL_COPY_READ_BUFFER, static_cast<GLsizeiptr>(kMaxEmitPerFrame * sizeof(GpuParticle)), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_COPY_READ_BUFFER, 0, static_cast<GLsizeiptr>(count * sizeof(GpuParticle)), m_pending.data());
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, destination);
+    const GLsizei first = std::min(count, m_capacity - m_writeCursor);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0,
+                        static_cast<GLintptr>(m_writeCursor * sizeof(GpuParticle)),
+                        static_cast<GLsizeiptr>(first * sizeof(GpuParticle)));
+    if (first < count) {
+        // Wrapped: the oldest particles at the start of the ring are replaced.
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(first * sizeof(GpuParticle)), 0,
+                            static_cast<GLsizeiptr>((count - first) * sizeof(GpuParticle)));
+    }
+
+    m_writeCursor = (m_writeCursor + count) % m_capacity;
+    m_batches.push_back({count, 0.0f});
+    m_liveCount += count;
+    // A full ring overwrites the oldest slots; drop them from the window.
+    while (m_liveCount > m_capacity) {
+        EmitBatch& oldest = m_batches.front();
+        const GLsizei overwritten = std::min(oldest.count, m_liveCount - m_capacity);
+        oldest.count -= overwritten;
+        m_liveCount -= overwritten;
+        if (oldest.count == 0) {
+            m_batches.pop_front();
+        }
+    }
+    m_pending.clear();
+}
+
+void ParticleSystem::expireBatches(float dt) {
+    for (EmitBatch& batch : m_batches) {
+        batch.age += dt;
+    }
+    // Every particle in a batch this old has reached its (clamped) lifetime.
+    while (!m_batches.empty() && m_batches.front().age >= kMaxLifetime) {
+        m_liveCount -= m_batches.front().count;
+        m_batches.pop_front();
+    }
+}
+
+int ParticleSystem::liveSpans(std::array<Span, 2>& spans) const {
+    if (m_liveCount == 0) {
+        return 0;
+    }
+    const GLsizei start = (m_writeCursor + m_capacity - m_liveCount) % m_capacity;
+    spans[0] = {start, std::min(m_liveCount, m_capacity - start)};
+    spans[1] = {0, m_liveCount - spans[0].count};
+    return spans[1].count > 0 ? 2 : 1;
+}
+
+void ParticleSystem::update(float dt) {
+    const int source = m_current;
+    const int destination = 1 - m_current;
+
+    expireBatches(dt);
+
+    std::array<Span, 2> spans;
+    const int spanCount = liveSpans(spans);
+    if (spanCount > 0) {
+        m_updateShader->use();
+        m_updateShader->setFloat("uDt", dt);
+        m_updateShader->setFloat("uGravity", kGravity);
+        m_updateShader->setVec3("uWind", m_wind);
+
+        glEnable(GL_RASTERIZER_DISCARD);
+        glBindVertexArray(m_updateVaos[static_cast<size_t>(source)]);
+        for (int i = 0; i < spanCount; ++i) {
+            const Span& span = spans[static_cast<size_t>(i)];
+            // Write back to the same slots so the ring layout is preserved.
+            glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_buffers[static_cast<size_t>(destination)],
+                              static_cast<GLintptr>(span.first * sizeof(GpuParticle)),
+                              static_cast<GLsizeiptr>(span.count * sizeof(GpuParticle)));
+            glBeginTransformFeedback(GL_POINTS);
+            glDrawArrays(GL_POINTS, span.first, span.count);
+            glEndTransformFeedback();
+        }
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        glBindVertexArray(0);
+        glDisable(GL_RASTERIZER_DISCARD);
+    }
+
+    appendPending(m_buffers[static_cast<size_t>(destination)]);
+    m_current = destination;
+}
+
+void ParticleSystem::draw(const glm::mat4& view, const glm::mat4& proj) const {
+    std::array<Span, 2> spans;
+    const int spanCount = liveSpans(spans);
+    if (spanCount == 0) {
+        return;
+    }
+
+    m_renderShader->use();
+    m_renderShader->setMat4("uView", view);
+    m_renderShader->setMat4("uProj", proj);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+
+    const size_t current = static_cast<size_t>(m_current);
+    glBindVertexArray(m_renderVaos[current]);
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffers[current]);
+    for (int i = 0; i < spanCount; ++i) {
+        const Span& span = spans[static_cast<size_t>(i)];
+        setParticleAttributes(1, 1, span.first);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, span.count);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+}
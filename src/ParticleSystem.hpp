@@ -0,0 +1,95 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <deque>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Shader.hpp"
+
+enum class ParticleKind { Dust = 0, Impact = 1, Rain = 2 };
+
+// GPU-resident particles. State lives in two buffers that a vertex shader
+// ping-pongs between with transform feedback, so the CPU never reads or
+// rewrites existing particles. New particles are collected on the CPU each
+// frame, uploaded into a small emit buffer and copied into a ring region of
+// the live buffer. Lifetimes are capped, so only the slots written within the
+// last kMaxLifetime seconds can hold live particles; updates and draws cover
+// just that window behind the write cursor (at most two spans when it wraps).
+class ParticleSystem {
+public:
+    static constexpr GLsizei kDefaultCapacity = 1 << 20;
+    static constexpr GLsizei kMaxEmitPerFrame = 16384;
+    // `emit` clamps lifetimes to this.
+    static constexpr float kMaxLifetime = 1.5f;
+
+    explicit ParticleSystem(GLsizei capacity = kDefaultCapacity);
+    ~ParticleSystem();
+
+    ParticleSystem(const ParticleSystem&) = delete;
+    ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+    void emit(ParticleKind kind, const glm::vec3& position, const glm::vec3& velocity, float lifetime, float size);
+
+    // Gameplay emitters; `dt` is the time the emission covers.
+    void emitDustTrail(const glm::vec3& feet, const glm::vec3& velocity, float dt);
+    void emitLandingImpact(const glm::vec3& feet, float impactSpeed);
+    void emitWeather(const glm::vec3& cameraPos, float dt);
+
+    // Rain drops spawned per second around the camera; 0 disables weather.
+    void setWeatherRate(float particlesPerSecond) { m_weatherRate = particlesPerSecond; }
+    void setWind(const glm::vec3& wind) { m_wind = wind; }
+
+    // Advances every particle by `dt` on the GPU and appends this frame's emissions.
+    void update(float dt);
+    void draw(const glm::mat4& view, const glm::mat4& proj) const;
+
+private:
+    struct GpuParticle {
+        glm::vec4 positionAge;
+        glm::vec4 velocityLifetime;
+        glm::vec2 sizeKind;
+    };
+
+    struct EmitBatch {
+        GLsizei count = 0;
+        float age = 0.0f;
+    };
+    struct Span {
+        GLsizei first = 0;
+        GLsizei count = 0;
+    };
+
+    GLsizei m_capacity = 0;
+    GLsizei m_writeCursor = 0;
+    // Slots directly behind the write cursor that may still be alive, made up
+    // of the batches appended less than kMaxLifetime ago (oldest first).
+    GLsizei m_liveCount = 0;
+    std::deque<EmitBatch> m_batches;
+    int m_current = 0;
+
+    std::array<GLuint, 2> m_buffers{};
+    std::array<GLuint, 2> m_updateVaos{};
+    std::array<GLuint, 2> m_renderVaos{};
+    GLuint m_quadVbo = 0;
+    GLuint m_emitBuffer = 0;
+
+    std::unique_ptr<Shader> m_updateShader;
+    std::unique_ptr<Shader> m_renderShader;
+
+    std::vector<GpuParticle> m_pending;
+    std::mt19937 m_rng{1337u};
+    float m_weatherRate = 4000.0f;
+    float m_weatherCarry = 0.0f;
+    float m_dustCarry = 0.0f;
+    glm::vec3 m_wind{1.5f, 0.0f, 0.6f};
+
+    float random(float lo, float hi);
+    void appendPending(GLuint destination);
+    void expireBatches(float dt);
+    int liveSpans(std::array<Span, 2>& spans) const;
+};
@@ -2,34 +2,61 @@
 
 #include <glm/glm.hpp>
 
+#include <type_traits>
+
 #include "InputState.hpp"
 #include "Terrain.hpp"
 
+// Everything update() reads or writes. Kept trivially copyable so a snapshot
+// is a plain memcpy, which is what prediction rewinds rely on.
+struct PlayerState {
+    glm::vec3 position{0.0f, 2.0f, 0.0f};
+    glm::vec3 velocity{0.0f};
+
+    float yaw = -90.0f;
+    float pitch = 0.0f;
+
+    bool grounded = false;
+    glm::vec3 groundNormal{0.0f, 1.0f, 0.0f};
+
+    bool sliding = false;
+    glm::vec3 slideDirection{0.0f};
+    float slideTimer = 0.0f;
+};
+
+static_assert(std::is_trivially_copyable_v<PlayerState>, "PlayerState must stay memcpy-able");
+
 class PlayerController {
 public:
+    static constexpr float kSlopeLimitDeg = 45.0f;
+
     PlayerController();
 
+    // True when a surface with this normal is shallow enough to stand on.
+    static bool isWalkableNormal(const glm::vec3& normal);
+
     void update(const InputState& input, float dt, const Terrain& terrain);
 
     glm::vec3 cameraPosition() const;
     glm::vec3 viewDirection() const;
     glm::mat4 viewMatrix() const;
 
-    bool isGrounded() const { return m_grounded; }
+    // Camera for a frame drawn `alpha` of a tick past the last simulated one:
+    // the eye is interpolated from `previous` (the state before that tick) and
+    // the look direction includes mouse motion no tick has consumed yet.
+    glm::vec3 cameraPosition(const PlayerState& previous, float alpha) const;
+    glm::mat4 viewMatrix(const PlayerState& previous, float alpha, const glm::vec2& pendingMouseDelta) const;
 
-private:
-    glm::vec3 m_position{0.0f, 2.0f, 0.0f};
-    glm::vec3 m_velocity{0.0f};
-
-    float m_yaw = -90.0f;
-    float m_pitch = 0.0f;
+    bool isGrounded() const { return m_state.grounded; }
+    bool isSliding() const { return m_state.sliding; }
+    glm::vec3 position() const { return m_state.position; }
+    glm::vec3 velocity() const { return m_state.velocity; }
 
-    bool m_grounded = false;
-    glm::vec3 m_groundNormal{0.0f, 1.0f, 0.0f};
+    PlayerState saveState() const { return m_state; }
+    void restoreState(const PlayerState& state) { m_state = state; }
 
-    bool m_sliding = false;
-    glm::vec3 m_slideDirection{0.0f};
-    float m_slideTimer = 0.0f;
+private:
+    PlayerState m_state;
 
     void applyFriction(float dt, float amount);
     void accelerate(const glm::vec3& wishDir, float wishSpeed, float accel, float dt);
@@ -0,0 +1,94 @@
+#include "PredictionHistory.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void PredictionHistory::clear() {
+    for (auto& entry : m_entries) {
+        entry.valid = false;
+    }
+    m_latestTick = 0;
+}
+
+void PredictionHistory::record(std::uint32_t tick, const InputState& input, float dt, const PlayerState& result) {
+    Entry& entry = slot(tick);
+    entry.tick = tick;
+    entry.valid = true;
+    entry.dt = dt;
+    entry.input = input;
+    entry.state = result;
+    m_latestTick = std::max(m_latestTick, tick);
+}
+
+const PredictionHistory::Entry* PredictionHistory::find(std::uint32_t tick) const {
+    const Entry& entry = slot(tick);
+    if (!entry.valid || entry.tick != tick) {
+        return nullptr;
+    }
+    return &entry;
+}
+
+void PredictionHistory::setTolerance(float positionTolerance, float velocityTolerance) {
+    m_positionTolerance = positionTolerance;
+    m_velocityTolerance = velocityTolerance;
+}
+
+bool PredictionHistory::statesMatch(const PlayerState& predicted, const PlayerState& authoritative,
+                                    ResimulationResult& result) const {
+    result.positionError = glm::length(predicted.position - authoritative.position);
+    result.velocityError = glm::length(predicted.velocity - authoritative.velocity);
+
+    return result.positionError <= m_positionTolerance && result.velocityError <= m_velocityTolerance &&
+           std::abs(predicted.yaw - authoritative.yaw) <= kAngleTolerance &&
+           std::abs(predicted.pitch - authoritative.pitch) <= kAngleTolerance &&
+           predicted.grounded == authoritative.grounded &&
+           glm::length(predicted.groundNormal - authoritative.groundNormal) <= kDirectionTolerance &&
+           predicted.sliding == authoritative.sliding &&
+           glm::length(predicted.slideDirection - authoritative.slideDirection) <= kDirectionTolerance &&
+           std::abs(predicted.slideTimer - authoritative.slideTimer) <= kTimerTolerance;
+}
+
+bool PredictionHistory::hasInputsAfter(std::uint32_t tick) const {
+    if (m_latestTick > tick && m_latestTick - tick >= kCapacity) {
+        return false;
+    }
+    for (std::uint32_t t = tick + 1; t <= m_latestTick; ++t) {
+        if (find(t) == nullptr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ResimulationResult PredictionHistory::resimulate(PlayerController& player, std::uint32_t tick,
+                                                 const PlayerState& authoritative, const Terrain& terrain) {
+    ResimulationResult result;
+
+    Entry& base = slot(tick);
+    const bool predicted = base.valid && base.tick == tick;
+    if (predicted && statesMatch(base.state, authoritative, result)) {
+        return result;
+    }
+    // Either diverged or never predicted; both need a rewind and replay.
+    result.diverged = true;
+
+    // Check the whole range first so a gap can't leave the player at a past tick.
+    if (!hasInputsAfter(tick)) {
+        result.incomplete = true;
+        return result;
+    }
+
+    if (predicted) {
+        base.state = authoritative;
+    }
+    player.restoreState(authoritative);
+
+    for (std::uint32_t t = tick + 1; t <= m_latestTick; ++t) {
+        Entry& entry = slot(t);
+        player.update(entry.input, entry.dt, terrain);
+        entry.state = player.saveState();
+        ++result.ticksReplayed;
+    }
+
+    return result;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "InputState.hpp"
+#include "PlayerController.hpp"
+#include "Terrain.hpp"
+
+struct ResimulationResult {
+    bool diverged = false;
+    float positionError = 0.0f;
+    float velocityError = 0.0f;
+    int ticksReplayed = 0;
+    // Some input after the authoritative tick is no longer buffered, so the
+    // present state cannot be rebuilt; the player was left untouched.
+    bool incomplete = false;
+};
+
+// Fixed-size ring of (tick, input, resulting state) used for client-side
+// prediction. Entries live inline so a rewind touches one contiguous block
+// and never allocates.
+class PredictionHistory {
+public:
+    static constexpr std::size_t kCapacity = 64;
+
+    struct Entry {
+        std::uint32_t tick = 0;
+        bool valid = false;
+        float dt = 0.0f;
+        InputState input;
+        PlayerState state;
+    };
+
+    void clear();
+
+    // Stores the input applied at `tick` and the state update() produced from it.
+    void record(std::uint32_t tick, const InputState& input, float dt, const PlayerState& result);
+
+    [[nodiscard]] const Entry* find(std::uint32_t tick) const;
+    std::uint32_t latestTick() const { return m_latestTick; }
+
+    // Compares the predicted state at `tick` with `authoritative`, field by
+    // field. On divergence (or when `tick` itself was never predicted) the
+    // player is rewound to `authoritative` and every newer input is replayed,
+    // overwriting the stored predictions. Without divergence nothing is
+    // replayed and the player is left untouched. If any input after `tick` is
+    // missing, nothing is changed and the result is marked incomplete.
+    ResimulationResult resimulate(PlayerController& player, std::uint32_t tick, const PlayerState& authoritative,
+                                  const Terrain& terrain);
+
+    void setTolerance(float positionTolerance, float velocityTolerance);
+
+private:
+    static_assert((kCapacity & (kCapacity - 1)) == 0, "kCapacity must be a power of two");
+
+    std::array<Entry, kCapacity> m_entries{};
+    std::uint32_t m_latestTick = 0;
+
+    float m_positionTolerance = 1e-3f;
+    float m_velocityTolerance = 1e-2f;
+    // Not exposed: these fields are either exact or derived from position/velocity.
+    static constexpr float kAngleTolerance = 1e-3f;
+    static constexpr float kDirectionTolerance = 1e-3f;
+    static constexpr float kTimerTolerance = 1e-4f;
+
+    bool statesMatch(const PlayerState& predicted, const PlayerState& authoritative, ResimulationResult& result) const;
+    bool hasInputsAfter(std::uint32_t tick) const;
+
+    Entry& slot(std::uint32_t tick) { return m_entries[tick & (kCapacity - 1)]; }
+    const Entry& slot(std::uint32_t tick) const { return m_entries[tick & (kCapacity - 1)]; }
+};
@@ -2,9 +2,29 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
 
-Renderer::Renderer(int viewportWidth, int viewportHeight) : m_width(viewportWidth), m_height(viewportHeight) {
+namespace {
+constexpr float kFieldOfViewDeg = 75.0f;
+
+// Terrain grid cells per occluder cell; keeps the occluder set to a few
+// hundred triangles.
+constexpr int kOccluderStep = 2;
+
+// Frames of GPU timings averaged before the resolution scale is revisited.
+constexpr int kScaleAdjustInterval = 8;
+// Ignore errors smaller than this fraction of the target to avoid flicker.
+constexpr float kScaleDeadband = 0.05f;
+// Largest relative scale change per adjustment.
+constexpr float kMaxScaleStep = 0.1f;
+}  // namespace
+
+Renderer::Renderer(int viewportWidth, int viewportHeight, WorkerPool& workers)
+    : m_width(viewportWidth), m_height(viewportHeight), m_culler(workers) {
     const char* vertexShader = R"(
         #version 410 core
         layout(location = 0) in vec3 aPos;
@@ -35,16 +55,37 @@ Renderer::Renderer(int viewportWidth, int viewportHeight) : m_width(viewportWidt
 
         out vec4 FragColor;
 
-        uniform sampler2D uGrassTex;
+        uniform sampler2DArray uMaterials;
+        uniform vec2 uHeightBands;  // dirt below x, snow above y
+        uniform float uHeightBlend;
+        uniform vec2 uRockSlope;
         uniform vec3 uLightDir;
         uniform vec3 uCameraPos;
 
+        // Must match TerrainMaterials::splatWeights.
+        vec4 splatWeights(float height, vec3 normal) {
+            float rock = smoothstep(uRockSlope.x, uRockSlope.y, 1.0 - normal.y);
+            float dirt = (1.0 - smoothstep(uHeightBands.x - uHeightBlend, uHeightBands.x, height)) * (1.0 - rock);
+            float snow = smoothstep(uHeightBands.y, uHeightBands.y + uHeightBlend, height) * (1.0 - rock);
+            return vec4(max(1.0 - rock - dirt - snow, 0.0), dirt, rock, snow);
+        }
+
         void main() {
             vec3 normal = normalize(vNormal);
             vec3 lightDir = normalize(-uLightDir);
             float lambert = max(dot(normal, lightDir), 0.18);
 
-            vec3 albedo = texture(uGrassTex, vUV).rgb;
+            // Only layers with weight are fetched; explicit gradients keep
+            // mip selection valid inside the branches.
+            vec4 weights = splatWeights(vWorldPos.y, normal);
+            vec2 dx = dFdx(vUV);
+            vec2 dy = dFdy(vUV);
+            vec3 albedo = vec3(0.0);
+            for (int layer = 0; layer < 4; ++layer) {
+                if (weights[layer] > 0.001) {
+                    albedo += weights[layer] * textureGrad(uMaterials, vec3(vUV, float(layer)), dx, dy).rgb;
+                }
+            }
             vec3 diffuse = albedo * lambert;
 
             vec3 viewDir = normalize(uCameraPos - vWorldPos);
@@ -55,62 +96,256 @@ Renderer::Renderer(int viewportWidth, int viewportHeight) : m_width(viewportWidt
         }
     )";
 
+    // Fullscreen triangle; bilinear upscale with a light unsharp pass that
+    // fades out as the scale approaches native.
+    const char* upscaleVertexShader = R"(
+        #version 410 core
+        out vec2 vUV;
+
+        void main() {
+            vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+            vUV = pos;
+            gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+        }
+    )";
+
+    const char* upscaleFragmentShader = R"(
+        #version 410 core
+        in vec2 vUV;
+
+        out vec4 FragColor;
+
+        uniform sampler2D uScene;
+        uniform vec2 uUVScale;
+        uniform vec2 uMaxUV;
+        uniform vec2 uTexelSize;
+        uniform float uSharpness;
+
+        vec3 fetch(vec2 uv) {
+            return texture(uScene, min(uv, uMaxUV)).rgb;
+        }
+
+        void main() {
+            vec2 uv = vUV * uUVScale;
+            vec3 center = fetch(uv);
+            vec3 blur = 0.25 * (fetch(uv + vec2(uTexelSize.x, 0.0)) + fetch(uv - vec2(uTexelSize.x, 0.0)) +
+                                fetch(uv + vec2(0.0, uTexelSize.y)) + fetch(uv - vec2(0.0, uTexelSize.y)));
+            FragColor = vec4(max(center + (center - blur) * uSharpness, 0.0), 1.0);
+        }
+    )";
+
     m_shader = std::make_unique<Shader>(vertexShader, fragmentShader);
-    createTexture();
+    m_upscaleShader = std::make_unique<Shader>(upscaleVertexShader, upscaleFragmentShader);
+
+    glGenVertexArrays(1, &m_fullscreenVao);
+    glGenQueries(static_cast<GLsizei>(m_timerQueries.size()), m_timerQueries.data());
 
     glEnable(GL_DEPTH_TEST);
-    glViewport(0, 0, m_width, m_height);
+    createSceneTarget();
+
+    m_particles = std::make_unique<ParticleSystem>();
+    m_materials = std::make_unique<TerrainMaterials>();
 }
 
-void Renderer::createTexture() {
-    std::array<unsigned char, 16 * 16 * 3> tex{};
+Renderer::~Renderer() {
+    destroySceneTarget();
+    glDeleteQueries(static_cast<GLsizei>(m_timerQueries.size()), m_timerQueries.data());
+    if (m_fullscreenVao) glDeleteVertexArrays(1, &m_fullscreenVao);
+}
 
-    for (int y = 0; y < 16; ++y) {
-        for (int x = 0; x < 16; ++x) {
-            const int i = (y * 16 + x) * 3;
-            const bool check = ((x / 2 + y / 2) % 2) == 0;
-            tex[i + 0] = static_cast<unsigned char>(check ? 72 : 48);
-            tex[i + 1] = static_cast<unsigned char>(check ? 150 : 120);
-            tex[i + 2] = static_cast<unsigned char>(check ? 66 : 44);
-        }
+void Renderer::createSceneTarget() {
+    if (m_width <= 0 || m_height <= 0) {
+        return;
     }
 
-    glGenTextures(1, &m_terrainTexture);
-    glBindTexture(GL_TEXTURE_2D, m_terrainTexture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glGenTextures(1, &m_sceneColor);
+    glBindTexture(GL_TEXTURE_2D, m_sceneColor);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    glGenRenderbuffers(1, &m_sceneDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_sceneDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_width, m_height);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, 16, 16, 0, GL_RGB, GL_UNSIGNED_BYTE, tex.data());
-    glGenerateMipmap(GL_TEXTURE_2D);
+    glGenFramebuffers(1, &m_sceneFbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_sceneFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_sceneColor, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_sceneDepth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        destroySceneTarget();
+        throw std::runtime_error("Scene framebuffer is incomplete");
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    m_targetWidth = m_width;
+    m_targetHeight = m_height;
+}
+
+void Renderer::destroySceneTarget() {
+    if (m_sceneFbo) glDeleteFramebuffers(1, &m_sceneFbo);
+    if (m_sceneDepth) glDeleteRenderbuffers(1, &m_sceneDepth);
+    if (m_sceneColor) glDeleteTextures(1, &m_sceneColor);
+    m_sceneFbo = 0;
+    m_sceneDepth = 0;
+    m_sceneColor = 0;
+    m_targetWidth = 0;
+    m_targetHeight = 0;
 }
 
 void Renderer::resize(int width, int height) {
     m_width = width;
     m_height = height;
-    glViewport(0, 0, width, height);
+    if (width != m_targetWidth || height != m_targetHeight) {
+        destroySceneTarget();
+        createSceneTarget();
+    }
+}
+
+void Renderer::setResolutionScaleLimits(float minScale, float maxScale) {
+    m_minScale = std::clamp(minScale, 0.1f, 1.0f);
+    m_maxScale = std::clamp(maxScale, m_minScale, 1.0f);
+    m_scale = std::clamp(m_scale, m_minScale, m_maxScale);
+}
+
+int Renderer::scaledWidth() const {
+    return std::max(1, static_cast<int>(std::lround(static_cast<float>(m_width) * m_scale)));
 }
 
-void Renderer::render(const Terrain& terrain, const glm::mat4& view, const glm::vec3& cameraPos) {
+int Renderer::scaledHeight() const {
+    return std::max(1, static_cast<int>(std::lround(static_cast<float>(m_height) * m_scale)));
+}
+
+void Renderer::collectGpuTimings() {
+    // Read back whatever finished without waiting; results are a few frames old.
+    for (size_t i = 0; i < m_timerQueries.size(); ++i) {
+        if (!m_timerPending[i]) {
+            continue;
+        }
+        GLint available = 0;
+        glGetQueryObjectiv(m_timerQueries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            continue;
+        }
+        GLuint64 elapsedNs = 0;
+        glGetQueryObjectui64v(m_timerQueries[i], GL_QUERY_RESULT, &elapsedNs);
+        m_timerPending[i] = false;
+
+        m_gpuFrameMs = static_cast<float>(elapsedNs) * 1e-6f;
+        m_gpuTimeAccumMs += m_gpuFrameMs;
+        ++m_gpuTimeSamples;
+    }
+}
+
+void Renderer::updateResolutionScale() {
+    if (m_gpuTimeSamples < kScaleAdjustInterval) {
+        return;
+    }
+
+    const float averageMs = m_gpuTimeAccumMs / static_cast<float>(m_gpuTimeSamples);
+    m_gpuTimeAccumMs = 0.0f;
+    m_gpuTimeSamples = 0;
+
+    if (!m_dynamicResolution || averageMs <= 0.0f) {
+        return;
+    }
+
+    const float error = (averageMs - m_targetFrameMs) / m_targetFrameMs;
+    if (std::abs(error) < kScaleDeadband) {
+        return;
+    }
+
+    // GPU cost is roughly proportional to pixel count, i.e. to scale squared.
+    const float ideal = m_scale * std::sqrt(m_targetFrameMs / averageMs);
+    const float step = std::clamp(ideal - m_scale, -kMaxScaleStep, kMaxScaleStep);
+    m_scale = std::clamp(m_scale + step, m_minScale, m_maxScale);
+}
+
+void Renderer::setTerrain(const Terrain& terrain) {
+    m_materials->setCoverage(terrain);
+
+    std::vector<glm::vec3> positions;
+    std::vector<unsigned int> indices;
+    terrain.buildOccluderMesh(kOccluderStep, positions, indices);
+    m_culler.setOccluders(std::move(positions), std::move(indices));
+}
+
+void Renderer::render(const Terrain& terrain, const glm::mat4& view, const glm::vec3& cameraPos, float frameDt) {
+    if (m_sceneFbo == 0) {
+        return;
+    }
+
+    collectGpuTimings();
+    updateResolutionScale();
+
+    const int sceneWidth = scaledWidth();
+    const int sceneHeight = scaledHeight();
+
+    const float fovY = glm::radians(kFieldOfViewDeg);
+    const glm::mat4 proj = glm::perspective(fovY, static_cast<float>(m_width) / static_cast<float>(m_height), 0.1f, 500.0f);
+
+    // CPU work, texture streaming and the resolution-independent particle
+    // step stay outside the timed region so they can't skew the scale.
+    m_materials->update(cameraPos, fovY, sceneHeight);
+    m_culler.cull(proj * view, terrain.chunkBounds(), m_chunkVisible);
+    // Transform feedback rasterizes nothing, so no target needs to be bound.
+    m_particles->update(frameDt);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_sceneFbo);
+    glViewport(0, 0, sceneWidth, sceneHeight);
+    glEnable(GL_DEPTH_TEST);
     glPolygonMode(GL_FRONT_AND_BACK, m_wireframe ? GL_LINE : GL_FILL);
 
+    const size_t query = m_frameIndex++ % m_timerQueries.size();
+    const bool timed = !m_timerPending[query];
+    if (timed) {
+        glBeginQuery(GL_TIME_ELAPSED, m_timerQueries[query]);
+    }
+
     glClearColor(0.54f, 0.72f, 0.96f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    const glm::mat4 proj = glm::perspective(glm::radians(75.0f), static_cast<float>(m_width) / static_cast<float>(m_height), 0.1f, 500.0f);
-
     m_shader->use();
     m_shader->setMat4("uView", view);
     m_shader->setMat4("uProj", proj);
     m_shader->setVec3("uLightDir", glm::normalize(glm::vec3(-0.25f, -1.0f, -0.35f)));
     m_shader->setVec3("uCameraPos", cameraPos);
 
+    m_materials->bind(*m_shader, 0);
+
+    terrain.draw(m_chunkVisible);
+
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    m_particles->draw(view, proj);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, m_width, m_height);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDisable(GL_DEPTH_TEST);
+
+    const glm::vec2 targetSize(static_cast<float>(m_targetWidth), static_cast<float>(m_targetHeight));
+    m_upscaleShader->use();
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_terrainTexture);
-    m_shader->setInt("uGrassTex", 0);
+    glBindTexture(GL_TEXTURE_2D, m_sceneColor);
+    m_upscaleShader->setInt("uScene", 0);
+    m_upscaleShader->setVec2("uUVScale", glm::vec2(static_cast<float>(sceneWidth), static_cast<float>(sceneHeight)) / targetSize);
+    m_upscaleShader->setVec2("uMaxUV", (glm::vec2(static_cast<float>(sceneWidth), static_cast<float>(sceneHeight)) - 0.5f) / targetSize);
+    m_upscaleShader->setVec2("uTexelSize", glm::vec2(1.0f) / targetSize);
+    m_upscaleShader->setFloat("uSharpness", (1.0f - m_scale) * 0.6f);
 
-    terrain.draw();
+    glBindVertexArray(m_fullscreenVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glEnable(GL_DEPTH_TEST);
+
+    if (timed) {
+        glEndQuery(GL_TIME_ELAPSED);
+        m_timerPending[query] = true;
+    }
 }
 
 void Renderer::toggleWireframe() {
@@ -3,27 +3,92 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
+#include "OcclusionCuller.hpp"
+#include "ParticleSystem.hpp"
 #include "Shader.hpp"
 #include "Terrain.hpp"
+#include "TerrainMaterials.hpp"
+
+class WorkerPool;
 
 class Renderer {
 public:
-    Renderer(int viewportWidth, int viewportHeight);
+    Renderer(int viewportWidth, int viewportHeight, WorkerPool& workers);
+    ~Renderer();
+
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
 
     void resize(int width, int height);
-    void render(const Terrain& terrain, const glm::mat4& view, const glm::vec3& cameraPos);
+    // Builds the per-terrain data: occluder mesh and material coverage.
+    void setTerrain(const Terrain& terrain);
+    // `frameDt` advances the particle simulation, which runs once per rendered frame.
+    void render(const Terrain& terrain, const glm::mat4& view, const glm::vec3& cameraPos, float frameDt);
     void toggleWireframe();
 
+    const OcclusionStats& occlusionStats() const { return m_culler.stats(); }
+    ParticleSystem& particles() { return *m_particles; }
+    TerrainMaterials& materials() { return *m_materials; }
+
+    // Dynamic resolution: the scene is drawn into an offscreen target at
+    // `resolutionScale()` times the framebuffer size and upscaled on present.
+    // The scale is steered towards the target GPU frame time every few frames.
+    void setResolutionScaleLimits(float minScale, float maxScale);
+    void setTargetFrameTime(float milliseconds) { m_targetFrameMs = milliseconds; }
+    void setDynamicResolution(bool enabled) { m_dynamicResolution = enabled; }
+    float minResolutionScale() const { return m_minScale; }
+    float maxResolutionScale() const { return m_maxScale; }
+    float resolutionScale() const { return m_scale; }
+    float gpuFrameTime() const { return m_gpuFrameMs; }
+
 private:
     int m_width = 0;
     int m_height = 0;
 
     bool m_wireframe = false;
-    GLuint m_terrainTexture = 0;
 
     std::unique_ptr<Shader> m_shader;
 
-    void createTexture();
+    std::unique_ptr<ParticleSystem> m_particles;
+    std::unique_ptr<TerrainMaterials> m_materials;
+
+    OcclusionCuller m_culler;
+    std::vector<std::uint8_t> m_chunkVisible;
+
+    // Offscreen scene target, allocated at full framebuffer size so scale
+    // changes only move the viewport.
+    GLuint m_sceneFbo = 0;
+    GLuint m_sceneColor = 0;
+    GLuint m_sceneDepth = 0;
+    int m_targetWidth = 0;
+    int m_targetHeight = 0;
+
+    std::unique_ptr<Shader> m_upscaleShader;
+    GLuint m_fullscreenVao = 0;
+
+    static constexpr size_t kTimerQueryCount = 4;
+    std::array<GLuint, kTimerQueryCount> m_timerQueries{};
+    std::array<bool, kTimerQueryCount> m_timerPending{};
+    size_t m_frameIndex = 0;
+
+    bool m_dynamicResolution = true;
+    float m_scale = 1.0f;
+    float m_minScale = 0.5f;
+    float m_maxScale = 1.0f;
+    float m_targetFrameMs = 1000.0f / 60.0f;
+    float m_gpuFrameMs = 0.0f;
+    float m_gpuTimeAccumMs = 0.0f;
+    int m_gpuTimeSamples = 0;
+
+    void createSceneTarget();
+    void destroySceneTarget();
+    void collectGpuTimings();
+    void updateResolutionScale();
+    int scaledWidth() const;
+    int scaledHeight() const;
 };
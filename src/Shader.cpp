@@ -34,11 +34,28 @@ Shader::Shader(const std::string& vertexSource, const std::string& fragmentSourc
     glAttachShader(m_programId, vertex);
     glAttachShader(m_programId, fragment);
     glLinkProgram(m_programId);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
 
+    checkLinkStatus();
+}
+
+Shader::Shader(const std::string& vertexSource, const std::vector<const char*>& feedbackVaryings) {
+    const GLuint vertex = compile(GL_VERTEX_SHADER, vertexSource);
+
+    m_programId = glCreateProgram();
+    glAttachShader(m_programId, vertex);
+    glTransformFeedbackVaryings(m_programId, static_cast<GLsizei>(feedbackVaryings.size()), feedbackVaryings.data(),
+                                GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(m_programId);
+    glDeleteShader(vertex);
+
+    checkLinkStatus();
+}
+
+void Shader::checkLinkStatus() {
     GLint success = 0;
     glGetProgramiv(m_programId, GL_LINK_STATUS, &success);
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
 
     if (!success) {
         GLint length = 0;
@@ -66,6 +83,10 @@ void Shader::setMat4(const char* name, const glm::mat4& value) const {
     glUniformMatrix4fv(glGetUniformLocation(m_programId, name), 1, GL_FALSE, glm::value_ptr(value));
 }
 
+void Shader::setVec2(const char* name, const glm::vec2& value) const {
+    glUniform2fv(glGetUniformLocation(m_programId, name), 1, glm::value_ptr(value));
+}
+
 void Shader::setVec3(const char* name, const glm::vec3& value) const {
     glUniform3fv(glGetUniformLocation(m_programId, name), 1, glm::value_ptr(value));
 }
@@ -4,10 +4,14 @@
 #include <glm/glm.hpp>
 
 #include <string>
+#include <vector>
 
 class Shader {
 public:
     Shader(const std::string& vertexSource, const std::string& fragmentSource);
+    // Vertex-only program whose outputs are captured with transform feedback
+    // (interleaved, in the given order).
+    Shader(const std::string& vertexSource, const std::vector<const char*>& feedbackVaryings);
     ~Shader();
 
     Shader(const Shader&) = delete;
@@ -17,6 +21,7 @@ public:
     GLuint id() const { return m_programId; }
 
     void setMat4(const char* name, const glm::mat4& value) const;
+    void setVec2(const char* name, const glm::vec2& value) const;
     void setVec3(const char* name, const glm::vec3& value) const;
     void setFloat(const char* name, float value) const;
     void setInt(const char* name, int value) const;
@@ -25,4 +30,5 @@ private:
     GLuint m_programId = 0;
 
     static GLuint compile(GLenum type, const std::string& source);
+    void checkLinkStatus();
 };
@@ -0,0 +1,140 @@
+#include "SpatialHash.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr std::uint32_t kMinBucketBits = 10;
+constexpr std::uint32_t kMinBuckets = 1u << kMinBucketBits;
+}  // namespace
+
+SpatialHash::SpatialHash(float cellSize) : m_cellSize(cellSize), m_inverseCellSize(1.0f / cellSize) {
+    m_bucketMask = kMinBuckets - 1;
+    m_bucketBitsX = (kMinBucketBits + 1) / 2;
+    m_bucketStart.assign(kMinBuckets + 1, 0);
+}
+
+std::int32_t SpatialHash::cellCoord(float value) const {
+    return static_cast<std::int32_t>(std::floor(value * m_inverseCellSize));
+}
+
+std::uint32_t SpatialHash::bucketOf(std::int32_t cellX, std::int32_t cellZ) const {
+    // Cells wrap around a 2^bitsX by 2^bitsZ torus instead of being scrambled,
+    // so neighbouring cells land in neighbouring buckets and a 3x3 stencil
+    // touches only a few cache lines of m_bucketStart.
+    const std::uint32_t x = static_cast<std::uint32_t>(cellX) & ((1u << m_bucketBitsX) - 1u);
+    const std::uint32_t z = static_cast<std::uint32_t>(cellZ) & (m_bucketMask >> m_bucketBitsX);
+    return (z << m_bucketBitsX) | x;
+}
+
+void SpatialHash::rebuild(const std::vector<glm::vec3>& positions) {
+    // Roughly two buckets per entity keeps collisions between distinct cells rare.
+    std::uint32_t buckets = kMinBuckets;
+    std::uint32_t bits = kMinBucketBits;
+    while (buckets < positions.size() * 2) {
+        buckets <<= 1;
+        ++bits;
+    }
+    m_bucketMask = buckets - 1;
+    m_bucketBitsX = (bits + 1) / 2;
+    m_bucketStart.assign(buckets + 1, 0);
+
+    m_entryBucket.resize(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        const std::uint32_t bucket = bucketOf(cellCoord(positions[i].x), cellCoord(positions[i].z));
+        m_entryBucket[i] = bucket;
+        ++m_bucketStart[bucket + 1];
+    }
+
+    for (std::uint32_t b = 0; b < buckets; ++b) {
+        m_bucketStart[b + 1] += m_bucketStart[b];
+    }
+
+    // Scatter using the prefix sums as write cursors, then shift them back.
+    m_entries.resize(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        Entry& entry = m_entries[m_bucketStart[m_entryBucket[i]]++];
+        entry.x = positions[i].x;
+        entry.z = positions[i].z;
+        entry.cellX = cellCoord(positions[i].x);
+        entry.cellZ = cellCoord(positions[i].z);
+        entry.id = static_cast<std::uint32_t>(i);
+    }
+    for (std::uint32_t b = buckets; b > 0; --b) {
+        m_bucketStart[b] = m_bucketStart[b - 1];
+    }
+    m_bucketStart[0] = 0;
+}
+
+template <typename Visit>
+void SpatialHash::forEachInCells(std::int32_t x0, std::int32_t z0, std::int32_t x1, std::int32_t z1, Visit&& visit) const {
+    for (std::int32_t cz = z0; cz <= z1; ++cz) {
+        for (std::int32_t cx = x0; cx <= x1; ++cx) {
+            const std::uint32_t bucket = bucketOf(cx, cz);
+            const std::uint32_t end = m_bucketStart[bucket + 1];
+            for (std::uint32_t i = m_bucketStart[bucket]; i < end; ++i) {
+                const Entry& entry = m_entries[i];
+                // Other cells can hash to the same bucket; the cell check also
+                // keeps an entity from being visited twice.
+                if (entry.cellX == cx && entry.cellZ == cz) {
+                    visit(entry);
+                }
+            }
+        }
+    }
+}
+
+void SpatialHash::queryRadius(const glm::vec3& center, float radius, std::vector<std::uint32_t>& out) const {
+    out.clear();
+    const float radiusSq = radius * radius;
+    forEachInCells(cellCoord(center.x - radius), cellCoord(center.z - radius), cellCoord(center.x + radius),
+                   cellCoord(center.z + radius), [&](const Entry& entry) {
+                       const float dx = entry.x - center.x;
+                       const float dz = entry.z - center.z;
+                       if (dx * dx + dz * dz <= radiusSq) {
+                           out.push_back(entry.id);
+                       }
+                   });
+}
+
+void SpatialHash::queryAabb(const glm::vec2& minXZ, const glm::vec2& maxXZ, std::vector<std::uint32_t>& out) const {
+    out.clear();
+    forEachInCells(cellCoord(minXZ.x), cellCoord(minXZ.y), cellCoord(maxXZ.x), cellCoord(maxXZ.y), [&](const Entry& entry) {
+        if (entry.x >= minXZ.x && entry.x <= maxXZ.x && entry.z >= minXZ.y && entry.z <= maxXZ.y) {
+            out.push_back(entry.id);
+        }
+    });
+}
+
+void SpatialHash::findPairs(float radius, std::vector<std::pair<std::uint32_t, std::uint32_t>>& out) const {
+    out.clear();
+    const float radiusSq = radius * radius;
+    const auto reach = static_cast<std::int32_t>(std::ceil(radius * m_inverseCellSize));
+
+    auto test = [&](const Entry& a, const Entry& b) {
+        const float dx = b.x - a.x;
+        const float dz = b.z - a.z;
+        if (dx * dx + dz * dz < radiusSq) {
+            out.emplace_back(std::min(a.id, b.id), std::max(a.id, b.id));
+        }
+    };
+
+    // Half stencil: later entries of the same cell, then only the cells
+    // "ahead" of this one, so every pair is tested exactly once.
+    for (std::uint32_t i = 0; i < m_entries.size(); ++i) {
+        const Entry& self = m_entries[i];
+
+        const std::uint32_t bucket = bucketOf(self.cellX, self.cellZ);
+        const std::uint32_t end = m_bucketStart[bucket + 1];
+        for (std::uint32_t j = i + 1; j < end; ++j) {
+            const Entry& other = m_entries[j];
+            if (other.cellX == self.cellX && other.cellZ == self.cellZ) {
+                test(self, other);
+            }
+        }
+
+        forEachInCells(self.cellX + 1, self.cellZ, self.cellX + reach, self.cellZ, [&](const Entry& other) { test(self, other); });
+        forEachInCells(self.cellX - reach, self.cellZ + 1, self.cellX + reach, self.cellZ + reach,
+                       [&](const Entry& other) { test(self, other); });
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Uniform grid on the XZ plane, wrapped into a power-of-two bucket table so
+// the world needs no fixed bounds. Entities are counting-sorted by bucket
+// on every rebuild, so each bucket is one contiguous run of (position, id)
+// records and queries stream through memory instead of chasing pointers.
+// Distances are measured on XZ only; height is ignored.
+//
+// Meant to be rebuilt once per tick from the current positions; ids are the
+// indices into the array passed to rebuild().
+class SpatialHash {
+public:
+    // Use Terrain::cellSpacing() unless entities are much larger than a terrain cell.
+    explicit SpatialHash(float cellSize);
+
+    void rebuild(const std::vector<glm::vec3>& positions);
+
+    float cellSize() const { return m_cellSize; }
+    std::size_t size() const { return m_entries.size(); }
+
+    // Ids within `radius` of `center`, in no particular order. `out` is cleared first.
+    void queryRadius(const glm::vec3& center, float radius, std::vector<std::uint32_t>& out) const;
+    // Ids inside the XZ rectangle [minXZ, maxXZ]. `out` is cleared first.
+    void queryAabb(const glm::vec2& minXZ, const glm::vec2& maxXZ, std::vector<std::uint32_t>& out) const;
+    // Every unordered pair closer than `radius`, each reported once with first < second.
+    void findPairs(float radius, std::vector<std::pair<std::uint32_t, std::uint32_t>>& out) const;
+
+private:
+    struct Entry {
+        float x;
+        float z;
+        std::int32_t cellX;
+        std::int32_t cellZ;
+        std::uint32_t id;
+    };
+
+    float m_cellSize = 1.0f;
+    float m_inverseCellSize = 1.0f;
+    std::uint32_t m_bucketMask = 0;
+    std::uint32_t m_bucketBitsX = 0;
+
+    // Bucket b owns m_entries[m_bucketStart[b], m_bucketStart[b + 1]).
+    std::vector<std::uint32_t> m_bucketStart;
+    std::vector<Entry> m_entries;
+    std::vector<std::uint32_t> m_entryBucket;
+
+    std::int32_t cellCoord(float value) const;
+    std::uint32_t bucketOf(std::int32_t cellX, std::int32_t cellZ) const;
+
+    template <typename Visit>
+    void forEachInCells(std::int32_t x0, std::int32_t z0, std::int32_t x1, std::int32_t z1, Visit&& visit) const;
+};
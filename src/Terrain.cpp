@@ -1,10 +1,14 @@
 #include "Terrain.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <limits>
 
 namespace {
-float heightField(float x, float z) {
+constexpr int kChunkCells = 6;
+
+float defaultHeight(float x, float z) {
     return 0.5f * std::sin(0.22f * x) + 0.4f * std::cos(0.19f * z);
 }
 
@@ -34,9 +38,14 @@ bool pointInTriangle2D(const glm::vec2& p, const glm::vec2& a, const glm::vec2&
 }
 }  // namespace
 
-Terrain::Terrain() {
+Terrain::Terrain(const TerrainSettings& settings)
+    : m_grid(settings.gridSize),
+      m_spacing(settings.cellSpacing),
+      m_height(settings.height ? settings.height : defaultHeight) {
     buildMesh();
-    upload();
+    if (settings.gpuMesh) {
+        upload();
+    }
 }
 
 Terrain::~Terrain() {
@@ -46,9 +55,10 @@ Terrain::~Terrain() {
 }
 
 void Terrain::buildMesh() {
-    constexpr int grid = 24;
-    constexpr float spacing = 2.5f;
+    const int grid = m_grid;
+    const float spacing = m_spacing;
     const float half = (grid * spacing) * 0.5f;
+    m_half = half;
 
     m_vertices.reserve((grid + 1) * (grid + 1));
 
@@ -56,11 +66,11 @@ void Terrain::buildMesh() {
         for (int x = 0; x <= grid; ++x) {
             const float worldX = x * spacing - half;
             const float worldZ = z * spacing - half;
-            const float worldY = heightField(worldX, worldZ);
+            const float worldY = m_height(worldX, worldZ);
 
             Vertex v{};
             v.position = glm::vec3(worldX, worldY, worldZ);
-            v.uv = glm::vec2(x / 4.0f, z / 4.0f);
+            v.uv = glm::vec2(x / kCellsPerUvRepeat, z / kCellsPerUvRepeat);
             m_vertices.push_back(v);
         }
     }
@@ -69,20 +79,43 @@ void Terrain::buildMesh() {
         return static_cast<unsigned int>(z * (grid + 1) + x);
     };
 
-    for (int z = 0; z < grid; ++z) {
-        for (int x = 0; x < grid; ++x) {
-            const unsigned int i0 = indexOf(x, z);
-            const unsigned int i1 = indexOf(x + 1, z);
-            const unsigned int i2 = indexOf(x, z + 1);
-            const unsigned int i3 = indexOf(x + 1, z + 1);
-
-            m_indices.push_back(i0);
-            m_indices.push_back(i2);
-            m_indices.push_back(i1);
-
-            m_indices.push_back(i1);
-            m_indices.push_back(i2);
-            m_indices.push_back(i3);
+    // Indices are grouped per chunk so each chunk is one contiguous draw range.
+    for (int chunkZ = 0; chunkZ < grid; chunkZ += kChunkCells) {
+        for (int chunkX = 0; chunkX < grid; chunkX += kChunkCells) {
+            TerrainChunk chunk;
+            chunk.firstIndex = static_cast<unsigned int>(m_indices.size());
+            chunk.bounds.min = glm::vec3(std::numeric_limits<float>::max());
+            chunk.bounds.max = glm::vec3(-std::numeric_limits<float>::max());
+
+            const int endZ = std::min(chunkZ + kChunkCells, grid);
+            const int endX = std::min(chunkX + kChunkCells, grid);
+            for (int z = chunkZ; z < endZ; ++z) {
+                for (int x = chunkX; x < endX; ++x) {
+                    const unsigned int i0 = indexOf(x, z);
+                    const unsigned int i1 = indexOf(x + 1, z);
+                    const unsigned int i2 = indexOf(x, z + 1);
+                    const unsigned int i3 = indexOf(x + 1, z + 1);
+
+                    m_indices.push_back(i0);
+                    m_indices.push_back(i2);
+                    m_indices.push_back(i1);
+
+                    m_indices.push_back(i1);
+                    m_indices.push_back(i2);
+                    m_indices.push_back(i3);
+                }
+            }
+
+            for (int z = chunkZ; z <= endZ; ++z) {
+                for (int x = chunkX; x <= endX; ++x) {
+                    chunk.bounds.min = glm::min(chunk.bounds.min, vertexAt(x, z).position);
+                    chunk.bounds.max = glm::max(chunk.bounds.max, vertexAt(x, z).position);
+                }
+            }
+
+            chunk.indexCount = static_cast<unsigned int>(m_indices.size()) - chunk.firstIndex;
+            m_chunks.push_back(chunk);
+            m_chunkBounds.push_back(chunk.bounds);
         }
     }
 
@@ -133,18 +166,109 @@ void Terrain::upload() {
     glBindVertexArray(0);
 }
 
-void Terrain::draw() const {
+void Terrain::draw(const std::vector<std::uint8_t>& chunkVisible) const {
     glBindVertexArray(m_vao);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indices.size()), GL_UNSIGNED_INT, nullptr);
+    for (size_t i = 0; i < m_chunks.size(); ++i) {
+        if (i < chunkVisible.size() && !chunkVisible[i]) {
+            continue;
+        }
+        const TerrainChunk& chunk = m_chunks[i];
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(chunk.indexCount), GL_UNSIGNED_INT,
+                       reinterpret_cast<void*>(static_cast<size_t>(chunk.firstIndex) * sizeof(unsigned int)));
+    }
     glBindVertexArray(0);
 }
 
+void Terrain::buildOccluderMesh(int step, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices) const {
+    positions.clear();
+    indices.clear();
+
+    // Each coarse cell becomes a flat terrace at the lowest height inside it,
+    // plus vertical walls up to the taller neighbour along shared edges. Both
+    // stay on or below the real surface, so the occluder never hides anything
+    // the full mesh would show.
+    const int cells = (m_grid + step - 1) / step;
+    std::vector<float> floorHeight(static_cast<size_t>(cells * cells));
+    for (int cz = 0; cz < cells; ++cz) {
+        for (int cx = 0; cx < cells; ++cx) {
+            float lowest = std::numeric_limits<float>::max();
+            for (int z = cz * step; z <= std::min((cz + 1) * step, m_grid); ++z) {
+                for (int x = cx * step; x <= std::min((cx + 1) * step, m_grid); ++x) {
+                    lowest = std::min(lowest, vertexAt(x, z).position.y);
+                }
+            }
+            floorHeight[static_cast<size_t>(cz * cells + cx)] = lowest;
+        }
+    }
+
+    auto worldCoord = [this, step](int cell) {
+        return std::min(cell * step, m_grid) * m_spacing - m_half;
+    };
+
+    auto addQuad = [&positions, &indices](const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d) {
+        const auto base = static_cast<unsigned int>(positions.size());
+        positions.push_back(a);
+        positions.push_back(b);
+        positions.push_back(c);
+        positions.push_back(d);
+        indices.insert(indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+    };
+
+    for (int cz = 0; cz < cells; ++cz) {
+        for (int cx = 0; cx < cells; ++cx) {
+            const float h = floorHeight[static_cast<size_t>(cz * cells + cx)];
+            const float x0 = worldCoord(cx);
+            const float x1 = worldCoord(cx + 1);
+            const float z0 = worldCoord(cz);
+            const float z1 = worldCoord(cz + 1);
+
+            addQuad({x0, h, z0}, {x0, h, z1}, {x1, h, z1}, {x1, h, z0});
+
+            if (cx + 1 < cells) {
+                const float other = floorHeight[static_cast<size_t>(cz * cells + cx + 1)];
+                if (std::abs(other - h) > 1e-3f) {
+                    const float lo = std::min(h, other);
+                    const float hi = std::max(h, other);
+                    addQuad({x1, lo, z0}, {x1, hi, z0}, {x1, hi, z1}, {x1, lo, z1});
+                }
+            }
+            if (cz + 1 < cells) {
+                const float other = floorHeight[static_cast<size_t>((cz + 1) * cells + cx)];
+                if (std::abs(other - h) > 1e-3f) {
+                    const float lo = std::min(h, other);
+                    const float hi = std::max(h, other);
+                    addQuad({x0, lo, z1}, {x0, hi, z1}, {x1, hi, z1}, {x1, lo, z1});
+                }
+            }
+        }
+    }
+}
+
 std::optional<SurfaceHit> Terrain::sampleSurface(float x, float z) const {
+    // The mesh is a regular grid, so the containing cell is found directly
+    // instead of scanning every triangle.
+    const float fx = (x + m_half) / m_spacing;
+    const float fz = (z + m_half) / m_spacing;
+    if (!(fx >= 0.0f && fz >= 0.0f && fx <= static_cast<float>(m_grid) && fz <= static_cast<float>(m_grid))) {
+        return std::nullopt;
+    }
+
+    const int cx = std::min(static_cast<int>(fx), m_grid - 1);
+    const int cz = std::min(static_cast<int>(fz), m_grid - 1);
+
+    const Vertex& v0 = vertexAt(cx, cz);
+    const Vertex& v1 = vertexAt(cx + 1, cz);
+    const Vertex& v2 = vertexAt(cx, cz + 1);
+    const Vertex& v3 = vertexAt(cx + 1, cz + 1);
+
+    // Same winding and split as buildMesh(): (i0, i2, i1) then (i1, i2, i3).
+    const Vertex* triangles[2][3] = {{&v0, &v2, &v1}, {&v1, &v2, &v3}};
+
     const glm::vec2 p(x, z);
-    for (size_t i = 0; i < m_indices.size(); i += 3) {
-        const Vertex& a = m_vertices[m_indices[i + 0]];
-        const Vertex& b = m_vertices[m_indices[i + 1]];
-        const Vertex& c = m_vertices[m_indices[i + 2]];
+    for (const auto& tri : triangles) {
+        const Vertex& a = *tri[0];
+        const Vertex& b = *tri[1];
+        const Vertex& c = *tri[2];
 
         glm::vec3 bary;
         if (!pointInTriangle2D(p, glm::vec2(a.position.x, a.position.z), glm::vec2(b.position.x, b.position.z),
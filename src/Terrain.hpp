@@ -3,25 +3,59 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <optional>
 #include <vector>
 
+#include "Bounds.hpp"
+
 struct SurfaceHit {
     float y = 0.0f;
     glm::vec3 normal{0.0f, 1.0f, 0.0f};
 };
 
+struct TerrainChunk {
+    Aabb bounds;
+    unsigned int firstIndex = 0;
+    unsigned int indexCount = 0;
+};
+
+using HeightFunction = float (*)(float x, float z);
+
+// Heightfield parameters. CPU-only users (the navigation benchmark) clear
+// `gpuMesh` so no GL context is needed.
+struct TerrainSettings {
+    int gridSize = 24;
+    float cellSpacing = 2.5f;
+    HeightFunction height = nullptr;  // null: the default rolling hills
+    bool gpuMesh = true;
+};
+
 class Terrain {
 public:
-    Terrain();
+    explicit Terrain(const TerrainSettings& settings = {});
     ~Terrain();
 
     Terrain(const Terrain&) = delete;
     Terrain& operator=(const Terrain&) = delete;
 
-    void draw() const;
+    // Draws only the chunks whose entry in `chunkVisible` is non-zero.
+    void draw(const std::vector<std::uint8_t>& chunkVisible) const;
+
+    [[nodiscard]] const std::vector<TerrainChunk>& chunks() const { return m_chunks; }
+    [[nodiscard]] const std::vector<Aabb>& chunkBounds() const { return m_chunkBounds; }
+
+    // Coarse, conservative occluder geometry (every `step` grid cells) for CPU occlusion culling.
+    void buildOccluderMesh(int step, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices) const;
     [[nodiscard]] std::optional<SurfaceHit> sampleSurface(float x, float z) const;
 
+    // The mesh covers [-halfExtent, halfExtent] on X and Z in gridSize() cells of cellSpacing().
+    float halfExtent() const { return m_half; }
+    float cellSpacing() const { return m_spacing; }
+    int gridSize() const { return m_grid; }
+    // World-space size of one repeat of the vertex UVs.
+    float textureRepeat() const { return kCellsPerUvRepeat * m_spacing; }
+
 private:
     struct Vertex {
         glm::vec3 position;
@@ -31,6 +65,15 @@ private:
 
     std::vector<Vertex> m_vertices;
     std::vector<unsigned int> m_indices;
+    std::vector<TerrainChunk> m_chunks;
+    std::vector<Aabb> m_chunkBounds;
+
+    static constexpr float kCellsPerUvRepeat = 4.0f;
+
+    int m_grid = 24;
+    float m_spacing = 2.5f;
+    float m_half = 0.0f;
+    HeightFunction m_height = nullptr;
 
     GLuint m_vao = 0;
     GLuint m_vbo = 0;
@@ -38,4 +81,6 @@ private:
 
     void buildMesh();
     void upload();
+
+    const Vertex& vertexAt(int x, int z) const { return m_vertices[static_cast<size_t>(z * (m_grid + 1) + x)]; }
 };
@@ -0,0 +1,438 @@
+#include "TerrainMaterials.hpp"
+
+#include "Shader.hpp"
+#include "Terrain.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+constexpr std::array<const char*, TerrainMaterials::kLayerCount> kLayerNames{"grass", "dirt", "rock", "snow"};
+
+// Splat bands, in world units. Slope is 1 - normal.y; the player's 45° limit is ~0.29.
+constexpr float kDirtBelow = -0.4f;
+constexpr float kSnowAbove = 0.55f;
+constexpr float kHeightBlend = 0.2f;
+constexpr float kRockSlopeStart = 0.1f;
+constexpr float kRockSlopeEnd = 0.25f;
+// Layers with less weight than this anywhere in a chunk don't count as covering it.
+constexpr float kCoverageThreshold = 0.01f;
+
+constexpr int kProceduralSize = 256;
+constexpr float kMaxAnisotropy = 8.0f;
+
+float smoothStep(float edge0, float edge1, float x) {
+    const float t = std::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+float latticeValue(int x, int y, int period, std::uint32_t seed) {
+    x = ((x % period) + period) % period;
+    y = ((y % period) + period) % period;
+    std::uint32_t h = static_cast<std::uint32_t>(x) * 374761393u + static_cast<std::uint32_t>(y) * 668265263u + seed * 2246822519u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    h ^= h >> 16;
+    return static_cast<float>(h & 0xffffu) / 65535.0f;
+}
+
+// Tileable value noise: `period` lattice cells span the texture.
+float tiledNoise(float u, float v, int period, std::uint32_t seed) {
+    const float x = u * static_cast<float>(period);
+    const float y = v * static_cast<float>(period);
+    const int x0 = static_cast<int>(std::floor(x));
+    const int y0 = static_cast<int>(std::floor(y));
+    const float fx = smoothStep(0.0f, 1.0f, x - static_cast<float>(x0));
+    const float fy = smoothStep(0.0f, 1.0f, y - static_cast<float>(y0));
+
+    const float top = latticeValue(x0, y0, period, seed) * (1.0f - fx) + latticeValue(x0 + 1, y0, period, seed) * fx;
+    const float bottom = latticeValue(x0, y0 + 1, period, seed) * (1.0f - fx) + latticeValue(x0 + 1, y0 + 1, period, seed) * fx;
+    return top * (1.0f - fy) + bottom * fy;
+}
+
+struct LayerLook {
+    glm::vec3 dark;
+    glm::vec3 light;
+    int period;
+};
+
+const std::array<LayerLook, TerrainMaterials::kLayerCount> kLayerLooks{{
+    {{0.18f, 0.36f, 0.14f}, {0.30f, 0.56f, 0.24f}, 16},
+    {{0.30f, 0.22f, 0.14f}, {0.47f, 0.36f, 0.23f}, 8},
+    {{0.30f, 0.29f, 0.28f}, {0.55f, 0.53f, 0.50f}, 4},
+    {{0.76f, 0.80f, 0.87f}, {0.95f, 0.96f, 0.98f}, 8},
+}};
+
+TextureLevel proceduralBaseLevel(const LayerLook& look, std::uint32_t seed) {
+    TextureLevel level;
+    level.width = kProceduralSize;
+    level.height = kProceduralSize;
+    level.data.resize(static_cast<size_t>(kProceduralSize * kProceduralSize * 4));
+
+    for (int y = 0; y < kProceduralSize; ++y) {
+        for (int x = 0; x < kProceduralSize; ++x) {
+            const float u = static_cast<float>(x) / static_cast<float>(kProceduralSize);
+            const float v = static_cast<float>(y) / static_cast<float>(kProceduralSize);
+            float n = 0.0f;
+            float amplitude = 0.5f;
+            for (int octave = 0; octave < 4; ++octave) {
+                n += amplitude * tiledNoise(u, v, look.period << octave, seed + static_cast<std::uint32_t>(octave));
+                amplitude *= 0.5f;
+            }
+            const glm::vec3 color = look.dark + (look.light - look.dark) * std::clamp(n / 0.9375f, 0.0f, 1.0f);
+
+            std::uint8_t* texel = &level.data[static_cast<size_t>((y * kProceduralSize + x) * 4)];
+            texel[0] = static_cast<std::uint8_t>(color.x * 255.0f + 0.5f);
+            texel[1] = static_cast<std::uint8_t>(color.y * 255.0f + 0.5f);
+            texel[2] = static_cast<std::uint8_t>(color.z * 255.0f + 0.5f);
+            texel[3] = 255;
+        }
+    }
+    return level;
+}
+
+TextureLevel downsample(const TextureLevel& source) {
+    TextureLevel level;
+    level.width = std::max(1, source.width / 2);
+    level.height = std::max(1, source.height / 2);
+    level.data.resize(static_cast<size_t>(level.width * level.height * 4));
+
+    for (int y = 0; y < level.height; ++y) {
+        for (int x = 0; x < level.width; ++x) {
+            const int x0 = std::min(x * 2, source.width - 1);
+            const int x1 = std::min(x * 2 + 1, source.width - 1);
+            const int y0 = std::min(y * 2, source.height - 1);
+            const int y1 = std::min(y * 2 + 1, source.height - 1);
+            for (int c = 0; c < 4; ++c) {
+                const auto at = [&](int sx, int sy) { return static_cast<int>(source.data[static_cast<size_t>((sy * source.width + sx) * 4 + c)]); };
+                level.data[static_cast<size_t>((y * level.width + x) * 4 + c)] =
+                    static_cast<std::uint8_t>((at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1) + 2) / 4);
+            }
+        }
+    }
+    return level;
+}
+
+std::uint16_t packRgb565(const std::uint8_t* rgb) {
+    return static_cast<std::uint16_t>(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3));
+}
+
+glm::ivec3 unpackRgb565(std::uint16_t color) {
+    const int r = (color >> 11) & 31;
+    const int g = (color >> 5) & 63;
+    const int b = color & 31;
+    return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+}
+
+// Bounding-box endpoints in four-colour mode; plenty for noise-like fallbacks.
+void encodeBc1Block(const std::array<std::uint8_t, 64>& rgba, std::uint8_t* out) {
+    std::uint8_t lo[3] = {255, 255, 255};
+    std::uint8_t hi[3] = {0, 0, 0};
+    for (size_t i = 0; i < 16; ++i) {
+        for (size_t c = 0; c < 3; ++c) {
+            lo[c] = std::min(lo[c], rgba[i * 4 + c]);
+            hi[c] = std::max(hi[c], rgba[i * 4 + c]);
+        }
+    }
+
+    std::uint16_t c0 = packRgb565(hi);
+    std::uint16_t c1 = packRgb565(lo);
+    if (c0 < c1) {
+        std::swap(c0, c1);
+    }
+
+    std::uint32_t indices = 0;
+    if (c0 != c1) {
+        const glm::ivec3 e0 = unpackRgb565(c0);
+        const glm::ivec3 e1 = unpackRgb565(c1);
+        const std::array<glm::ivec3, 4> palette{e0, e1, (e0 * 2 + e1) / 3, (e0 + e1 * 2) / 3};
+        for (size_t i = 0; i < 16; ++i) {
+            const glm::ivec3 texel(rgba[i * 4], rgba[i * 4 + 1], rgba[i * 4 + 2]);
+            std::uint32_t best = 0;
+            int bestDistance = 1 << 30;
+            for (std::uint32_t p = 0; p < 4; ++p) {
+                const glm::ivec3 d = texel - palette[p];
+                const int distance = d.x * d.x + d.y * d.y + d.z * d.z;
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= best << (i * 2);
+        }
+    }
+
+    out[0] = static_cast<std::uint8_t>(c0 & 0xff);
+    out[1] = static_cast<std::uint8_t>(c0 >> 8);
+    out[2] = static_cast<std::uint8_t>(c1 & 0xff);
+    out[3] = static_cast<std::uint8_t>(c1 >> 8);
+    for (int i = 0; i < 4; ++i) {
+        out[4 + i] = static_cast<std::uint8_t>((indices >> (i * 8)) & 0xff);
+    }
+}
+
+TextureLevel encodeBc1(const TextureLevel& source) {
+    const int blocksX = std::max(1, (source.width + 3) / 4);
+    const int blocksY = std::max(1, (source.height + 3) / 4);
+
+    TextureLevel level;
+    level.width = source.width;
+    level.height = source.height;
+    level.data.resize(static_cast<size_t>(blocksX * blocksY * 8));
+
+    std::array<std::uint8_t, 64> block{};
+    for (int by = 0; by < blocksY; ++by) {
+        for (int bx = 0; bx < blocksX; ++bx) {
+            // Levels smaller than a block repeat their edge texels.
+            for (int y = 0; y < 4; ++y) {
+                for (int x = 0; x < 4; ++x) {
+                    const int sx = std::min(bx * 4 + x, source.width - 1);
+                    const int sy = std::min(by * 4 + y, source.height - 1);
+                    for (int c = 0; c < 4; ++c) {
+                        block[static_cast<size_t>((y * 4 + x) * 4 + c)] = source.data[static_cast<size_t>((sy * source.width + sx) * 4 + c)];
+                    }
+                }
+            }
+            encodeBc1Block(block, &level.data[static_cast<size_t>((by * blocksX + bx) * 8)]);
+        }
+    }
+    return level;
+}
+
+std::vector<TextureImage> buildProceduralLayers(bool compress) {
+    std::vector<TextureImage> layers;
+    for (size_t layer = 0; layer < kLayerLooks.size(); ++layer) {
+        TextureImage image;
+        image.compressed = compress;
+        image.internalFormat = compress ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGBA8;
+
+        TextureLevel level = proceduralBaseLevel(kLayerLooks[layer], static_cast<std::uint32_t>(layer * 16 + 1));
+        while (true) {
+            const bool last = level.width == 1 && level.height == 1;
+            TextureLevel next = last ? TextureLevel{} : downsample(level);
+            image.levels.push_back(compress ? encodeBc1(level) : std::move(level));
+            if (last) {
+                break;
+            }
+            level = std::move(next);
+        }
+        layers.push_back(std::move(image));
+    }
+    return layers;
+}
+
+float distanceToBox(const glm::vec3& point, const Aabb& box) {
+    const glm::vec3 d = glm::max(glm::max(box.min - point, point - box.max), glm::vec3(0.0f));
+    return std::sqrt(glm::dot(d, d));
+}
+}  // namespace
+
+TerrainMaterials::TerrainMaterials(const std::string& directory) {
+    m_stats.budgetBytes = kDefaultBudgetBytes;
+
+    const bool s3tc = GLEW_EXT_texture_compression_s3tc == GL_TRUE;
+    adoptLayers(buildProceduralLayers(s3tc), false);
+
+    std::vector<std::string> paths;
+    for (const char* name : kLayerNames) {
+        paths.push_back(directory + "/" + name + ".dds");
+    }
+    const bool present = std::all_of(paths.begin(), paths.end(), [](const std::string& path) { return std::ifstream(path).good(); });
+    if (!s3tc || !present) {
+        return;
+    }
+
+    // Not on the WorkerPool: its FIFO also runs the occlusion cull every frame,
+    // which would stall behind a long read. update() swaps the layers in once ready.
+    m_pendingLoad = std::async(std::launch::async, [this, paths] {
+        std::vector<TextureImage> layers;
+        for (const std::string& path : paths) {
+            layers.push_back(loadDds(path));
+        }
+        const TextureImage& first = layers.front();
+        for (const TextureImage& layer : layers) {
+            if (layer.internalFormat != first.internalFormat || layer.levels.size() != first.levels.size() ||
+                layer.levels[0].width != first.levels[0].width || layer.levels[0].height != first.levels[0].height) {
+                throw std::runtime_error("Terrain layers must share format, size and mip count");
+            }
+        }
+        m_fileLayers = std::move(layers);
+    });
+}
+
+TerrainMaterials::~TerrainMaterials() {
+    if (m_pendingLoad.valid()) {
+        m_pendingLoad.wait();
+    }
+    if (m_texture) glDeleteTextures(1, &m_texture);
+}
+
+glm::vec4 TerrainMaterials::splatWeights(float height, const glm::vec3& normal) {
+    const float rock = smoothStep(kRockSlopeStart, kRockSlopeEnd, 1.0f - normal.y);
+    const float dirt = (1.0f - smoothStep(kDirtBelow - kHeightBlend, kDirtBelow, height)) * (1.0f - rock);
+    const float snow = smoothStep(kSnowAbove, kSnowAbove + kHeightBlend, height) * (1.0f - rock);
+    const float grass = std::max(0.0f, 1.0f - rock - dirt - snow);
+    return {grass, dirt, rock, snow};
+}
+
+void TerrainMaterials::setCoverage(const Terrain& terrain) {
+    for (std::vector<Aabb>& boxes : m_coverage) {
+        boxes.clear();
+    }
+    m_tileSize = terrain.textureRepeat();
+
+    const float step = terrain.cellSpacing() * 0.5f;
+    for (const TerrainChunk& chunk : terrain.chunks()) {
+        glm::vec4 maxWeight(0.0f);
+        for (float z = chunk.bounds.min.z; z <= chunk.bounds.max.z; z += step) {
+            for (float x = chunk.bounds.min.x; x <= chunk.bounds.max.x; x += step) {
+                if (const std::optional<SurfaceHit> hit = terrain.sampleSurface(x, z)) {
+                    maxWeight = glm::max(maxWeight, splatWeights(hit->y, hit->normal));
+                }
+            }
+        }
+        for (int layer = 0; layer < kLayerCount; ++layer) {
+            if (maxWeight[layer] > kCoverageThreshold) {
+                m_coverage[static_cast<size_t>(layer)].push_back(chunk.bounds);
+            }
+        }
+    }
+    m_hasCoverage = true;
+}
+
+void TerrainMaterials::adoptLayers(std::vector<TextureImage> layers, bool fromFiles) {
+    m_layers = std::move(layers);
+    m_stats.levelCount = static_cast<int>(m_layers.front().levels.size());
+    m_stats.compressed = m_layers.front().compressed;
+    m_stats.fromFiles = fromFiles;
+    // Start coarse and refine a level per frame.
+    upload(m_stats.levelCount - 1);
+}
+
+std::size_t TerrainMaterials::bytesFrom(int level) const {
+    std::size_t bytes = 0;
+    for (const TextureImage& layer : m_layers) {
+        for (size_t i = static_cast<size_t>(level); i < layer.levels.size(); ++i) {
+            bytes += layer.levels[i].data.size();
+        }
+    }
+    return bytes;
+}
+
+int TerrainMaterials::levelForDistance(float distance, float fovYRadians, int viewportHeight) const {
+    // Finest level whose texels are still no larger than a pixel at this distance.
+    const float pixelSize = distance * 2.0f * std::tan(fovYRadians * 0.5f) / static_cast<float>(std::max(1, viewportHeight));
+    const float texelSize = m_tileSize / static_cast<float>(m_layers.front().levels.front().width);
+    const float ratio = pixelSize / texelSize;
+    const int level = ratio <= 1.0f ? 0 : static_cast<int>(std::floor(std::log2(ratio)));
+    return std::clamp(level, 0, m_stats.levelCount - 1);
+}
+
+void TerrainMaterials::update(const glm::vec3& cameraPos, float fovYRadians, int viewportHeight) {
+    if (m_pendingLoad.valid() && m_pendingLoad.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        try {
+            m_pendingLoad.get();
+            adoptLayers(std::move(m_fileLayers), true);
+        } catch (const std::exception& ex) {
+            // A bad asset shouldn't take the game down; keep the current layers.
+            m_stats.loadError = ex.what();
+        }
+        m_fileLayers.clear();
+    }
+
+    int target = m_hasCoverage ? m_stats.levelCount - 1 : 0;
+    if (m_hasCoverage) {
+        for (const std::vector<Aabb>& boxes : m_coverage) {
+            for (const Aabb& box : boxes) {
+                target = std::min(target, levelForDistance(distanceToBox(cameraPos, box), fovYRadians, viewportHeight));
+            }
+        }
+    }
+
+    int budgetLevel = 0;
+    while (budgetLevel < m_stats.levelCount - 1 && bytesFrom(budgetLevel) > m_stats.budgetBytes) {
+        ++budgetLevel;
+    }
+    target = std::max(target, budgetLevel);
+    m_stats.targetLevel = target;
+
+    const int resident = m_stats.residentLevel;
+    if (target < resident) {
+        refine();
+    } else if (target > resident + 1 || bytesFrom(resident) > m_stats.budgetBytes) {
+        // Drop detail only once it is clearly unneeded, so the boundary doesn't thrash.
+        upload(target);
+    }
+}
+
+void TerrainMaterials::defineLevel(int level) const {
+    const TextureImage& first = m_layers.front();
+    const TextureLevel& mip = first.levels[static_cast<size_t>(level)];
+    std::vector<std::uint8_t> packed;
+    for (const TextureImage& layer : m_layers) {
+        const std::vector<std::uint8_t>& data = layer.levels[static_cast<size_t>(level)].data;
+        packed.insert(packed.end(), data.begin(), data.end());
+    }
+
+    if (first.compressed) {
+        glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, first.internalFormat, mip.width, mip.height, kLayerCount, 0,
+                               static_cast<GLsizei>(packed.size()), packed.data());
+    } else {
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, mip.width, mip.height, kLayerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                     packed.data());
+    }
+}
+
+void TerrainMaterials::refine() {
+    // Levels keep their chain indices, so a finer level is defined in place and
+    // exposed by lowering the base level; resident levels are not re-sent.
+    const int level = m_stats.residentLevel - 1;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+    defineLevel(level);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, level);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    m_stats.residentLevel = level;
+    m_stats.residentBytes = bytesFrom(level);
+}
+
+void TerrainMaterials::upload(int baseLevel) {
+    // Used for new layers and for dropping detail: a mutable texture can't free
+    // a level once defined, so the array is re-created with levels [baseLevel, end).
+    if (m_texture) glDeleteTextures(1, &m_texture);
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+
+    for (int level = baseLevel; level < m_stats.levelCount; ++level) {
+        defineLevel(level);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, baseLevel);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, m_stats.levelCount - 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    if (GLEW_EXT_texture_filter_anisotropic) {
+        GLfloat maxAnisotropy = 1.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+        glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY_EXT, std::min(kMaxAnisotropy, maxAnisotropy));
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    m_stats.residentLevel = baseLevel;
+    m_stats.residentBytes = bytesFrom(baseLevel);
+}
+
+void TerrainMaterials::bind(const Shader& shader, int unit) const {
+    glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(unit));
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+    shader.setInt("uMaterials", unit);
+    shader.setVec2("uHeightBands", glm::vec2(kDirtBelow, kSnowAbove));
+    shader.setFloat("uHeightBlend", kHeightBlend);
+    shader.setVec2("uRockSlope", glm::vec2(kRockSlopeStart, kRockSlopeEnd));
+}
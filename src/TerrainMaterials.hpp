@@ -0,0 +1,82 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "Bounds.hpp"
+#include "DdsLoader.hpp"
+
+class Shader;
+class Terrain;
+
+struct TextureStreamingStats {
+    int residentLevel = 0;
+    int targetLevel = 0;
+    int levelCount = 0;
+    std::size_t residentBytes = 0;
+    std::size_t budgetBytes = 0;
+    bool compressed = false;
+    bool fromFiles = false;
+    // Why the .dds layers were rejected; the procedural set stays in use.
+    std::string loadError;
+};
+
+// Terrain material layers (grass, dirt, rock, snow) in one texture array, so
+// the splat shader samples every layer through a single bind. Layers are
+// loaded from `<directory>/<layer>.dds` on a dedicated thread when all four
+// are present, so per-frame pool work never waits behind file I/O; until
+// then (or without them) a procedural set, BC1-compressed on the CPU,
+// stands in. Full mip chains stay in system memory and only the
+// levels from `residentLevel` down are uploaded, picked each frame from the
+// distance to the nearest terrain a layer covers and capped by a VRAM budget.
+class TerrainMaterials {
+public:
+    static constexpr int kLayerCount = 4;
+    static constexpr std::size_t kDefaultBudgetBytes = std::size_t{64} << 20;
+
+    explicit TerrainMaterials(const std::string& directory = "assets/terrain");
+    ~TerrainMaterials();
+
+    TerrainMaterials(const TerrainMaterials&) = delete;
+    TerrainMaterials& operator=(const TerrainMaterials&) = delete;
+
+    // Splat weights for (grass, dirt, rock, snow); the terrain shader computes the same.
+    static glm::vec4 splatWeights(float height, const glm::vec3& normal);
+
+    // Records which terrain chunks each layer shows up on, for distance-based streaming.
+    void setCoverage(const Terrain& terrain);
+    void setBudget(std::size_t bytes) { m_stats.budgetBytes = bytes; }
+
+    // `viewportHeight` is the rendered height in pixels; lower render scales
+    // need less texture detail.
+    void update(const glm::vec3& cameraPos, float fovYRadians, int viewportHeight);
+    // Binds the array to `unit` and sets the splat uniforms on `shader`.
+    void bind(const Shader& shader, int unit) const;
+
+    const TextureStreamingStats& stats() const { return m_stats; }
+
+private:
+    std::vector<TextureImage> m_layers;
+    std::vector<TextureImage> m_fileLayers;
+    std::future<void> m_pendingLoad;
+
+    std::array<std::vector<Aabb>, kLayerCount> m_coverage;
+    bool m_hasCoverage = false;
+    float m_tileSize = 10.0f;
+
+    GLuint m_texture = 0;
+    TextureStreamingStats m_stats;
+
+    void adoptLayers(std::vector<TextureImage> layers, bool fromFiles);
+    std::size_t bytesFrom(int level) const;
+    int levelForDistance(float distance, float fovYRadians, int viewportHeight) const;
+    void upload(int baseLevel);
+    void refine();
+    void defineLevel(int level) const;
+};
@@ -25,7 +25,14 @@ Window::Window(int width, int height, const char* title) : m_width(width), m_hei
     glfwMakeContextCurrent(m_window);
     glfwSetWindowUserPointer(m_window, this);
     glfwSetFramebufferSizeCallback(m_window, framebufferSizeCallback);
+    glfwSetKeyCallback(m_window, keyCallback);
+    glfwSetCursorPosCallback(m_window, cursorPosCallback);
     glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (glfwRawMouseMotionSupported()) {
+        glfwSetInputMode(m_window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
+        m_rawMouseMotion = true;
+    }
 }
 
 Window::~Window() {
@@ -47,52 +54,119 @@ void Window::swapBuffers() {
     glfwSwapBuffers(m_window);
 }
 
-InputState Window::consumeInput() {
-    InputState input;
+void Window::setTitle(const std::string& title) {
+    glfwSetWindowTitle(m_window, title.c_str());
+}
 
-    input.moveForward = glfwGetKey(m_window, GLFW_KEY_W) == GLFW_PRESS;
-    input.moveBackward = glfwGetKey(m_window, GLFW_KEY_S) == GLFW_PRESS;
-    input.moveLeft = glfwGetKey(m_window, GLFW_KEY_A) == GLFW_PRESS;
-    input.moveRight = glfwGetKey(m_window, GLFW_KEY_D) == GLFW_PRESS;
-    input.jumpHeld = glfwGetKey(m_window, GLFW_KEY_SPACE) == GLFW_PRESS;
-    input.sprintHeld = glfwGetKey(m_window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS;
-    input.crouchHeld = glfwGetKey(m_window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS;
-
-    const bool jumpDown = input.jumpHeld;
-    input.jumpPressed = jumpDown && !m_jumpWasDown;
-    m_jumpWasDown = jumpDown;
-
-    const bool wireframeDown = glfwGetKey(m_window, GLFW_KEY_F1) == GLFW_PRESS;
-    input.toggleWireframePressed = wireframeDown && !m_wireframeWasDown;
-    m_wireframeWasDown = wireframeDown;
-
-    double x = 0.0;
-    double y = 0.0;
-    glfwGetCursorPos(m_window, &x, &y);
-
-    static bool firstMouse = true;
-    static double prevX = x;
-    static double prevY = y;
-
-    if (firstMouse) {
-        prevX = x;
-        prevY = y;
-        firstMouse = false;
+int Window::trackedKey(int glfwKey) {
+    switch (glfwKey) {
+        case GLFW_KEY_W: return kForward;
+        case GLFW_KEY_S: return kBackward;
+        case GLFW_KEY_A: return kLeft;
+        case GLFW_KEY_D: return kRight;
+        case GLFW_KEY_SPACE: return kJump;
+        case GLFW_KEY_LEFT_SHIFT: return kSprint;
+        case GLFW_KEY_LEFT_CONTROL: return kCrouch;
+        case GLFW_KEY_F1: return kWireframe;
+        default: return -1;
     }
+}
 
-    input.mouseDeltaX = static_cast<float>(x - prevX);
-    input.mouseDeltaY = static_cast<float>(prevY - y);
+InputState Window::consumeInput(std::uint64_t tickEndNs) {
+    bool heldDuringTick[kTrackedKeyCount];
+    bool pressedDuringTick[kTrackedKeyCount] = {};
+    for (int i = 0; i < kTrackedKeyCount; ++i) {
+        heldDuringTick[i] = m_keyDown[i];
+    }
 
-    prevX = x;
-    prevY = y;
+    InputState input;
 
-    if (glfwGetKey(m_window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-        glfwSetWindowShouldClose(m_window, GLFW_TRUE);
+    while (const InputEvent* event = m_events.front()) {
+        if (event->timestampNs > tickEndNs) {
+            break;
+        }
+
+        if (event->type == InputEvent::Type::Key) {
+            m_keyDown[event->key] = event->pressed;
+            if (event->pressed) {
+                heldDuringTick[event->key] = true;
+                pressedDuringTick[event->key] = true;
+            }
+        } else {
+            input.mouseDeltaX += event->deltaX;
+            input.mouseDeltaY += event->deltaY;
+        }
+
+        m_events.pop();
     }
 
+    input.moveForward = heldDuringTick[kForward];
+    input.moveBackward = heldDuringTick[kBackward];
+    input.moveLeft = heldDuringTick[kLeft];
+    input.moveRight = heldDuringTick[kRight];
+    input.jumpHeld = heldDuringTick[kJump];
+    input.jumpPressed = pressedDuringTick[kJump];
+    input.sprintHeld = heldDuringTick[kSprint];
+    input.crouchHeld = heldDuringTick[kCrouch];
+    input.toggleWireframePressed = pressedDuringTick[kWireframe];
+
     return input;
 }
 
+glm::vec2 Window::pendingMouseDelta() const {
+    glm::vec2 delta(0.0f);
+    for (std::size_t i = 0; const InputEvent* event = m_events.peek(i); ++i) {
+        if (event->type == InputEvent::Type::MouseMove) {
+            delta.x += event->deltaX;
+            delta.y += event->deltaY;
+        }
+    }
+    return delta;
+}
+
 void Window::framebufferSizeCallback(GLFWwindow* /*window*/, int width, int height) {
     glViewport(0, 0, width, height);
 }
+
+void Window::keyCallback(GLFWwindow* window, int key, int /*scancode*/, int action, int /*mods*/) {
+    if (action == GLFW_REPEAT) {
+        return;
+    }
+
+    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
+        glfwSetWindowShouldClose(window, GLFW_TRUE);
+        return;
+    }
+
+    const int tracked = trackedKey(key);
+    if (tracked < 0) {
+        return;
+    }
+
+    auto* self = static_cast<Window*>(glfwGetWindowUserPointer(window));
+    InputEvent event;
+    event.type = InputEvent::Type::Key;
+    event.key = tracked;
+    event.pressed = action == GLFW_PRESS;
+    event.timestampNs = inputTimestampNow();
+    self->m_events.push(event);
+}
+
+void Window::cursorPosCallback(GLFWwindow* window, double x, double y) {
+    auto* self = static_cast<Window*>(glfwGetWindowUserPointer(window));
+    if (!self->m_haveCursor) {
+        self->m_cursorX = x;
+        self->m_cursorY = y;
+        self->m_haveCursor = true;
+        return;
+    }
+
+    InputEvent event;
+    event.type = InputEvent::Type::MouseMove;
+    event.deltaX = static_cast<float>(x - self->m_cursorX);
+    event.deltaY = static_cast<float>(self->m_cursorY - y);
+    event.timestampNs = inputTimestampNow();
+    self->m_cursorX = x;
+    self->m_cursorY = y;
+    self->m_events.push(event);
+}
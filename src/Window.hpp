@@ -1,7 +1,12 @@
 #pragma once
 
 #include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
 
+#include <cstdint>
+#include <string>
+
+#include "InputQueue.hpp"
 #include "InputState.hpp"
 
 class Window {
@@ -12,20 +17,43 @@ public:
     bool shouldClose() const;
     void pollEvents();
     void swapBuffers();
+    void setTitle(const std::string& title);
 
     GLFWwindow* handle() const { return m_window; }
     int width() const { return m_width; }
     int height() const { return m_height; }
 
-    InputState consumeInput();
+    // Builds the input for one simulation tick from every queued event with a
+    // timestamp at or before `tickEndNs`. Keys count as held if they were down
+    // at any point during the tick, so taps shorter than a tick still register.
+    InputState consumeInput(std::uint64_t tickEndNs);
+    // Mouse motion queued but not yet consumed by a tick, so the camera can
+    // turn with it this frame instead of one tick later.
+    glm::vec2 pendingMouseDelta() const;
+
+    bool rawMouseMotion() const { return m_rawMouseMotion; }
 
 private:
+    enum TrackedKey { kForward, kBackward, kLeft, kRight, kJump, kSprint, kCrouch, kWireframe, kTrackedKeyCount };
+
     GLFWwindow* m_window = nullptr;
     int m_width = 0;
     int m_height = 0;
+    bool m_rawMouseMotion = false;
+
+    InputEventQueue m_events;
+
+    // Producer side: only touched from GLFW callbacks.
+    bool m_haveCursor = false;
+    double m_cursorX = 0.0;
+    double m_cursorY = 0.0;
+
+    // Consumer side: key state as of the last consumed event.
+    bool m_keyDown[kTrackedKeyCount] = {};
 
-    bool m_jumpWasDown = false;
-    bool m_wireframeWasDown = false;
+    static int trackedKey(int glfwKey);
 
     static void framebufferSizeCallback(GLFWwindow* window, int width, int height);
+    static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+    static void cursorPosCallback(GLFWwindow* window, double x, double y);
 };
@@ -0,0 +1,100 @@
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <exception>
+
+namespace {
+// The pool whose worker is running on this thread, if any.
+thread_local const WorkerPool* t_currentPool = nullptr;
+}  // namespace
+
+WorkerPool::WorkerPool(unsigned int threadCount) {
+    if (threadCount == 0) {
+        const unsigned int hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    m_threads.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back([this] { workerLoop(); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+std::future<void> WorkerPool::submit(std::function<void()> job) {
+    std::packaged_task<void()> task(std::move(job));
+    std::future<void> result = task.get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push(std::move(task));
+    }
+    m_wake.notify_one();
+    return result;
+}
+
+void WorkerPool::parallelFor(std::size_t count, const std::function<void(std::size_t, std::size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    if (t_currentPool == this) {
+        body(0, count);
+        return;
+    }
+
+    const std::size_t slices = std::min<std::size_t>(count, m_threads.size() + 1);
+    const std::size_t perSlice = (count + slices - 1) / slices;
+
+    std::vector<std::future<void>> pending;
+    pending.reserve(slices);
+    for (std::size_t begin = perSlice; begin < count; begin += perSlice) {
+        const std::size_t end = std::min(begin + perSlice, count);
+        pending.push_back(submit([&body, begin, end] { body(begin, end); }));
+    }
+
+    // The caller takes the first slice instead of idling. Queued slices hold
+    // `body` by reference, so all of them must finish before anything unwinds.
+    std::exception_ptr failure;
+    try {
+        body(0, std::min(perSlice, count));
+    } catch (...) {
+        failure = std::current_exception();
+    }
+    for (auto& job : pending) {
+        job.wait();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    for (auto& job : pending) {
+        job.get();
+    }
+}
+
+void WorkerPool::workerLoop() {
+    t_currentPool = this;
+    for (;;) {
+        std::packaged_task<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+            if (m_stopping && m_jobs.empty()) {
+                return;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop();
+        }
+        job();
+    }
+}
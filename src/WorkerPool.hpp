@@ -0,0 +1,40 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Small fixed-size thread pool shared by the CPU-side systems (culling,
+// pathfinding). Jobs are plain closures; submit() hands back a future.
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned int threadCount = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned int threadCount() const { return static_cast<unsigned int>(m_threads.size()); }
+
+    std::future<void> submit(std::function<void()> job);
+
+    // Splits [0, count) into roughly even ranges, runs them on the pool and
+    // on the calling thread, and returns once all of them are done. Called
+    // from one of this pool's own jobs it runs everything inline instead,
+    // since waiting on the queue from a worker can deadlock the pool.
+    void parallelFor(std::size_t count, const std::function<void(std::size_t begin, std::size_t end)>& body);
+
+private:
+    std::vector<std::thread> m_threads;
+    std::queue<std::packaged_task<void()>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+
+    void workerLoop();
+};
@@ -1,53 +1,152 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include "FramePacer.hpp"
 #include "PlayerController.hpp"
 #include "Renderer.hpp"
 #include "Terrain.hpp"
 #include "Window.hpp"
+#include "WorkerPool.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <exception>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 
-int main() {
+namespace {
+constexpr const char* kWindowTitle = "Minimal FPS Engine";
+
+constexpr std::uint64_t kTickNs = 1'000'000'000ull / 120;
+constexpr float kTickSeconds = static_cast<float>(kTickNs) * 1e-9f;
+constexpr int kMaxTicksPerFrame = 8;
+
+// Landings slower than this (m/s) don't kick up dust.
+constexpr float kMinImpactSpeed = 4.0f;
+
+// Accepts --frames-in-flight=N and --fps-cap=N.
+FramePacingSettings parseFramePacing(int argc, char** argv) {
+    FramePacingSettings settings;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const std::string framesInFlight = "--frames-in-flight=";
+        const std::string fpsCap = "--fps-cap=";
+        if (arg.rfind(framesInFlight, 0) == 0) {
+            settings.maxFramesInFlight = std::max(0, std::stoi(arg.substr(framesInFlight.size())));
+        } else if (arg.rfind(fpsCap, 0) == 0) {
+            settings.frameRateCap = std::max(0.0f, std::stof(arg.substr(fpsCap.size())));
+        } else {
+            throw std::runtime_error("Unknown argument: " + arg);
+        }
+    }
+    return settings;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
     try {
-        Window window(1280, 720, "Minimal FPS Engine");
+        const FramePacingSettings pacing = parseFramePacing(argc, argv);
+
+        Window window(1280, 720, kWindowTitle);
 
         glewExperimental = GL_TRUE;
         if (glewInit() != GLEW_OK) {
             throw std::runtime_error("Failed to initialize GLEW");
         }
 
-        Renderer renderer(window.width(), window.height());
+        WorkerPool workers;
+        Renderer renderer(window.width(), window.height(), workers);
         Terrain terrain;
         PlayerController player;
+        renderer.setTerrain(terrain);
+        FramePacer pacer(pacing);
 
-        using clock = std::chrono::high_resolution_clock;
-        auto previous = clock::now();
+        using clock = std::chrono::steady_clock;
+        auto lastReport = clock::now();
 
-        while (!window.shouldClose()) {
-            const auto now = clock::now();
-            float dt = std::chrono::duration<float>(now - previous).count();
-            previous = now;
-            dt = std::min(dt, 0.033f);
+        // Simulation runs in fixed ticks; each tick consumes the input events
+        // stamped inside its time window. GLFW has no OS event times, so events
+        // are stamped when pollEvents() delivers them, i.e. once per frame.
+        std::uint64_t simulatedUntilNs = inputTimestampNow();
+        std::uint64_t lastFrameNs = simulatedUntilNs;
+        // State before the most recent tick, for interpolating the camera.
+        PlayerState previousState = player.saveState();
 
+        while (!window.shouldClose()) {
+            pacer.waitForFrameStart();
             window.pollEvents();
-            const InputState input = window.consumeInput();
+            pacer.markInputSampled();
 
-            if (input.toggleWireframePressed) {
-                renderer.toggleWireframe();
+            const std::uint64_t nowNs = inputTimestampNow();
+            const float frameDt = std::min(static_cast<float>(nowNs - lastFrameNs) * 1e-9f, kTickSeconds * kMaxTicksPerFrame);
+            lastFrameNs = nowNs;
+
+            ParticleSystem& particles = renderer.particles();
+            int ticks = 0;
+            while (simulatedUntilNs + kTickNs <= nowNs && ticks < kMaxTicksPerFrame) {
+                simulatedUntilNs += kTickNs;
+                const InputState input = window.consumeInput(simulatedUntilNs);
+
+                if (input.toggleWireframePressed) {
+                    renderer.toggleWireframe();
+                }
+
+                previousState = player.saveState();
+                const bool wasGrounded = player.isGrounded();
+                const float fallSpeed = -player.velocity().y;
+                player.update(input, kTickSeconds, terrain);
+
+                if (!wasGrounded && player.isGrounded() && fallSpeed > kMinImpactSpeed) {
+                    particles.emitLandingImpact(player.position(), fallSpeed);
+                }
+                if (player.isSliding()) {
+                    particles.emitDustTrail(player.position(), player.velocity(), kTickSeconds);
+                }
+                ++ticks;
+            }
+            if (ticks == kMaxTicksPerFrame) {
+                // Too far behind (debugger, window drag): drop the backlog.
+                simulatedUntilNs = nowNs;
             }
 
+            // Render between the last two ticks, with the look direction
+            // already including mouse motion that is still queued.
+            const float alpha = static_cast<float>(nowNs - simulatedUntilNs) / static_cast<float>(kTickNs);
+            const glm::vec3 eye = player.cameraPosition(previousState, alpha);
+            const glm::mat4 view = player.viewMatrix(previousState, alpha, window.pendingMouseDelta());
+
+            particles.emitWeather(eye, frameDt);
+
             int fbWidth = 0;
             int fbHeight = 0;
             glfwGetFramebufferSize(window.handle(), &fbWidth, &fbHeight);
             renderer.resize(fbWidth, fbHeight);
 
-            player.update(input, dt, terrain);
-            renderer.render(terrain, player.viewMatrix(), player.cameraPosition());
+            renderer.render(terrain, view, eye, frameDt);
 
             window.swapBuffers();
+            pacer.endFrame();
+
+            const auto now = clock::now();
+            if (now - lastReport >= std::chrono::seconds(1)) {
+                lastReport = now;
+                const OcclusionStats& occlusion = renderer.occlusionStats();
+                const FrameLatencyStats& latency = pacer.latency();
+                const TextureStreamingStats& textures = renderer.materials().stats();
+                char title[384];
+                std::snprintf(title, sizeof(title),
+                              "%s | occluded %d/%d (%.0f%%) offscreen %d | cull %.3f ms | gpu %.2f ms @ %.0f%% res"
+                              " | latency %.1f ms (max %.1f) | terrain mip %d (%.1f MB)%s%s",
+                              kWindowTitle, occlusion.occluded, occlusion.tested, occlusion.hitRate * 100.0f,
+                              occlusion.offscreen, occlusion.cullMs, renderer.gpuFrameTime(),
+                              renderer.resolutionScale() * 100.0f, latency.averageMs, latency.maxMs, textures.residentLevel,
+                              static_cast<double>(textures.residentBytes) / (1024.0 * 1024.0),
+                              textures.loadError.empty() ? "" : " | texture load failed: ", textures.loadError.c_str());
+                window.setTitle(title);
+            }
         }
     } catch (const std::exception& ex) {
         std::cerr << "Fatal error: " << ex.what() << '\n';